@@ -0,0 +1,112 @@
+#pragma once
+
+// CPU pinning for the benchmark threads. CPU sets are given in the kernel's
+// cpulist format ("0-3,8,10-11"); a NUMA node is pinned to through the CPUs
+// listed in /sys/devices/system/node/node<N>/cpulist. The node a block device
+// hangs off is read from the numa_node attribute of the nearest bus device
+// (PCI function of an NVMe drive or HBA) above it in sysfs.
+
+#include <sched.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <climits>
+#include <cstdlib>
+#include <cerrno>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Parses a cpulist such as "0-3,8". Returns false on malformed input.
+static inline bool parse_cpu_list(const std::string& list, std::vector<int>& cpus) {
+    size_t start = 0;
+    while (start < list.size()) {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos) comma = list.size();
+        std::string range = list.substr(start, comma - start);
+        size_t dash = range.find('-');
+        try {
+            int first = std::stoi(range.substr(0, dash));
+            int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+            if (first < 0 || last < first) return false;
+            for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+        } catch (const std::exception&) {
+            return false;
+        }
+        start = comma + 1;
+    }
+    return true;
+}
+
+// CPUs of NUMA node `node`, or an empty set if the node does not exist
+static inline std::vector<int> numa_node_cpus(int node) {
+    std::vector<int> cpus;
+    std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string list;
+    if (in >> list && !parse_cpu_list(list, cpus)) {
+        cpus.clear();
+    }
+    return cpus;
+}
+
+// NUMA node of the block device holding `path` (or of `path` itself when it
+// is a device node), or -1 if it has none: no block device (tmpfs, overlay,
+// NFS), a single-node machine, or a stacked device (dm, md) whose parents the
+// kernel does not tie to one node
+static inline int device_numa_node(const std::string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        size_t slash = path.rfind('/');
+        std::string parent = (slash == std::string::npos) ? "." : path.substr(0, slash);
+        if (stat(parent.c_str(), &st) != 0) return -1;
+    }
+    dev_t dev_id = S_ISBLK(st.st_mode) ? st.st_rdev : st.st_dev;
+    if (major(dev_id) == 0) return -1;
+    std::string link = "/sys/dev/block/" + std::to_string(major(dev_id)) + ":" + std::to_string(minor(dev_id));
+    char resolved[PATH_MAX];
+    if (!realpath(link.c_str(), resolved)) return -1;
+    // A partition sits below its disk, the disk below its controller; the
+    // first ancestor carrying numa_node is the device on the bus
+    std::string dir = resolved;
+    while (dir.size() > 1) {
+        for (const char* attr : {"/numa_node", "/device/numa_node"}) {
+            std::ifstream in(dir + attr);
+            int node;
+            if (in >> node) return node;
+        }
+        size_t slash = dir.rfind('/');
+        if (slash == std::string::npos || slash == 0) break;
+        dir.resize(slash);
+    }
+    return -1;
+}
+
+// Formats CPUs back into cpulist form, e.g. {0,1,2,8} as "0-2,8"
+static inline std::string format_cpu_list(const std::vector<int>& cpus) {
+    std::string out;
+    for (size_t i = 0; i < cpus.size(); i++) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) j++;
+        if (!out.empty()) out += ",";
+        out += std::to_string(cpus[i]);
+        if (j > i) out += "-" + std::to_string(cpus[j]);
+        i = j;
+    }
+    return out;
+}
+
+// Restricts the calling thread to `cpus`. Returns false on error.
+static inline bool pin_current_thread(const std::vector<int>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        std::cerr << "Error pinning thread to CPUs " << format_cpu_list(cpus) 
+                  << " (errno: " << errno << ")" << std::endl;
+        return false;
+    }
+    return true;
+}
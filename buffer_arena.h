@@ -0,0 +1,183 @@
+#pragma once
+
+// Aligned I/O buffers carved out of one region that is mapped once at startup.
+// Engines borrow buffers with acquire() and hand them back with release(), so
+// the measured loops never call into the allocator. The region can be backed
+// by huge pages (MAP_HUGETLB, falling back to transparent huge pages) and
+// mlock()ed so page faults and reclaim stay out of the measurements, and
+// bound to one NUMA node with mbind() so the I/O buffers sit next to the
+// device and the threads using them.
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+// <numaif.h> is part of libnuma's headers; the syscall needs only these
+#ifndef MPOL_BIND
+#define MPOL_BIND 2
+#endif
+#ifndef MPOL_MF_STRICT
+#define MPOL_MF_STRICT (1 << 0)
+#endif
+#ifndef MPOL_MF_MOVE
+#define MPOL_MF_MOVE (1 << 1)
+#endif
+
+class BufferArena {
+public:
+    BufferArena() = default;
+    BufferArena(const BufferArena&) = delete;
+    BufferArena& operator=(const BufferArena&) = delete;
+    ~BufferArena() { destroy(); }
+
+    // Maps `count` buffers of `buffer_size` bytes, each rounded up to and
+    // aligned on `alignment`, on NUMA node `numa_node` (-1 for wherever the
+    // kernel places them). Returns false if the region cannot be set up.
+    bool init(size_t count, size_t buffer_size, size_t alignment, bool huge_pages, bool lock,
+              int numa_node = -1) {
+        const size_t HUGE_PAGE = 2 * 1024 * 1024;
+        stride = (buffer_size + alignment - 1) / alignment * alignment;
+        size = count * stride;
+        if (size == 0) return true;
+
+        if (huge_pages) {
+            length = (size + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+            void* mapped = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (mapped != MAP_FAILED) {
+                region = static_cast<char*>(mapped);
+                backing = "hugetlb pages";
+            } else {
+                std::cout << "Warning: no hugetlb pages available (errno: " << errno
+                          << "), using transparent huge pages for the buffer arena" << std::endl;
+            }
+        }
+        if (!region) {
+            length = huge_pages ? (size + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE : size;
+            void* mapped = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mapped == MAP_FAILED) {
+                std::cerr << "Error mapping buffer arena of " << length << " bytes (errno: "
+                          << errno << ")" << std::endl;
+                return false;
+            }
+            region = static_cast<char*>(mapped);
+            backing = "base pages";
+            if (huge_pages && madvise(region, length, MADV_HUGEPAGE) == 0) {
+                backing = "transparent huge pages";
+            }
+        }
+        // The policy must be in place before the first touch below
+        if (numa_node >= 0 && !bind(numa_node)) {
+            destroy();
+            return false;
+        }
+        if (lock) {
+            if (mlock(region, length) != 0) {
+                std::cerr << "Error locking buffer arena of " << length << " bytes (errno: " << errno
+                          << "); raise ulimit -l or run without --arena_mlock" << std::endl;
+                destroy();
+                return false;
+            }
+            locked = true;
+        }
+        // Fault every page in now rather than on first use in a measured loop
+        memset(region, 0, length);
+
+        for (size_t i = count; i-- > 0;) {
+            free_buffers.push_back(region + i * stride);
+        }
+        return true;
+    }
+
+    void destroy() {
+        if (region) {
+            if (locked) munlock(region, length);
+            munmap(region, length);
+        }
+        region = nullptr;
+        locked = false;
+        free_buffers.clear();
+    }
+
+    // Lends out one buffer, or nullptr if all are in use
+    char* acquire() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (free_buffers.empty()) {
+            std::cerr << "Error: buffer arena exhausted" << std::endl;
+            return nullptr;
+        }
+        char* buffer = free_buffers.back();
+        free_buffers.pop_back();
+        return buffer;
+    }
+
+    void release(char* buffer) {
+        if (!buffer) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        free_buffers.push_back(buffer);
+    }
+
+    size_t buffer_size() const { return stride; }
+    int node() const { return bound_node; }
+    size_t bytes() const { return length; }
+    const char* backed_by() const { return backing; }
+    bool is_locked() const { return locked; }
+
+private:
+    bool bind(int numa_node) {
+        const unsigned long BITS = 8 * sizeof(unsigned long);
+        std::vector<unsigned long> mask(numa_node / BITS + 1, 0);
+        mask[numa_node / BITS] |= 1ul << (numa_node % BITS);
+        if (syscall(SYS_mbind, region, length, MPOL_BIND, mask.data(), mask.size() * BITS + 1,
+                    MPOL_MF_STRICT | MPOL_MF_MOVE) != 0) {
+            std::cerr << "Error binding buffer arena to NUMA node " << numa_node << " (errno: " << errno << ")"
+                      << std::endl;
+            return false;
+        }
+        bound_node = numa_node;
+        return true;
+    }
+
+    char* region = nullptr;
+    size_t stride = 0;
+    size_t size = 0;
+    size_t length = 0;
+    bool locked = false;
+    int bound_node = -1;
+    const char* backing = "none";
+    std::mutex mutex;
+    std::vector<char*> free_buffers;
+};
+
+// Buffers borrowed from an arena for the lifetime of a loop, returned on scope exit
+class ArenaLease {
+public:
+    explicit ArenaLease(BufferArena& arena) : arena(arena) {}
+    ~ArenaLease() {
+        for (char* buffer : buffers) arena.release(buffer);
+    }
+    ArenaLease(const ArenaLease&) = delete;
+    ArenaLease& operator=(const ArenaLease&) = delete;
+
+    // Borrows `count` more buffers. Returns false if the arena runs out.
+    bool take(size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            char* buffer = arena.acquire();
+            if (!buffer) return false;
+            buffers.push_back(buffer);
+        }
+        return true;
+    }
+
+    char* operator[](size_t i) const { return buffers[i]; }
+    size_t size() const { return buffers.size(); }
+
+private:
+    BufferArena& arena;
+    std::vector<char*> buffers;
+};
@@ -0,0 +1,169 @@
+#pragma once
+
+// Page-cache state of the working set, set per file instead of through the
+// global /proc/sys/vm/drop_caches: no root needed and no other process on the
+// host loses its cache. Cold evicts every file (flush, then
+// posix_fadvise(DONTNEED)); warm prefetches every file with readahead();
+// partial warms an evenly spread fraction of the files and evicts the rest.
+// Afterwards the resident pages are counted with cachestat() (Linux 6.5+, or
+// mincore() on older kernels) so a run shows the cache state it really had.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef __NR_cachestat
+#define __NR_cachestat 451
+#endif
+
+class CacheControl {
+public:
+    // Where entry `file_num` lives: a file and the byte range of it
+    struct Extent {
+        std::string path;
+        off_t offset;
+        long long length;
+    };
+    using ExtentOf = std::function<Extent(int file_num)>;
+
+    // Pages of the working set counted by measure()
+    struct Residency {
+        long long cached = 0;
+        long long dirty = 0;
+        long long total = 0;
+        const char* method = "cachestat";
+    };
+
+    // "keep" (leave the cache alone), "cold", "warm" or "partial:<fraction>".
+    // Returns false on a malformed value.
+    bool parse(const std::string& state) {
+        mode = state;
+        if (state == "keep" || state == "cold" || state == "warm") return true;
+        if (state.rfind("partial:", 0) == 0) {
+            try {
+                warm_fraction = std::stod(state.substr(8));
+            } catch (const std::exception&) {
+                return false;
+            }
+            mode = "partial";
+            return warm_fraction >= 0 && warm_fraction <= 1;
+        }
+        return false;
+    }
+
+    bool enabled() const { return mode != "keep"; }
+
+    // Brings entries 1..num_files into the requested state. Returns false on error.
+    bool apply(int num_files, const ExtentOf& extent_of) const {
+        for (int i = 1; i <= num_files; i++) {
+            Extent extent = extent_of(i);
+            int fd = open(extent.path.c_str(), O_RDONLY);
+            if (fd == -1) {
+                std::cerr << "Error opening " << extent.path << " for cache control (errno: " << errno << ")"
+                          << std::endl;
+                return false;
+            }
+            bool ok = is_warm(i) ? warm(fd, extent) : evict(fd, extent);
+            close(fd);
+            if (!ok) return false;
+        }
+        return true;
+    }
+
+    // Counts the resident pages of entries 1..num_files
+    Residency measure(int num_files, const ExtentOf& extent_of) const {
+        Residency r;
+        for (int i = 1; i <= num_files; i++) {
+            Extent extent = extent_of(i);
+            int fd = open(extent.path.c_str(), O_RDONLY);
+            if (fd == -1) continue;
+            count_pages(fd, extent, r);
+            close(fd);
+        }
+        return r;
+    }
+
+    // Files `apply` warms: every file, none, or floor(i * fraction) stepping up
+    bool is_warm(int file_num) const {
+        if (mode == "warm") return true;
+        if (mode != "partial") return false;
+        return (long long)(file_num * warm_fraction) > (long long)((file_num - 1) * warm_fraction);
+    }
+
+    const std::string& state() const { return mode; }
+
+private:
+    // Dirty pages survive DONTNEED, so write them back first
+    static bool evict(int fd, const Extent& extent) {
+        if (sync_file_range(fd, extent.offset, extent.length,
+                            SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER) != 0 &&
+            errno != ESPIPE && errno != EINVAL) {
+            std::cerr << "Error flushing " << extent.path << " (errno: " << errno << ")" << std::endl;
+            return false;
+        }
+        int ret = posix_fadvise(fd, extent.offset, extent.length, POSIX_FADV_DONTNEED);
+        if (ret != 0) {
+            std::cerr << "Error evicting " << extent.path << " (errno: " << ret << ")" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    static bool warm(int fd, const Extent& extent) {
+        if (readahead(fd, extent.offset, (size_t)extent.length) != 0) {
+            std::cerr << "Error prefetching " << extent.path << " (errno: " << errno << ")" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // struct cachestat_range / struct cachestat of <linux/mman.h>, which older headers lack
+    struct CachestatRange {
+        uint64_t off;
+        uint64_t len;
+    };
+    struct Cachestat {
+        uint64_t nr_cache;
+        uint64_t nr_dirty;
+        uint64_t nr_writeback;
+        uint64_t nr_evicted;
+        uint64_t nr_recently_evicted;
+    };
+
+    void count_pages(int fd, const Extent& extent, Residency& r) const {
+        const long page = sysconf(_SC_PAGESIZE);
+        long long first = extent.offset / page;
+        long long last = (extent.offset + extent.length + page - 1) / page;
+        r.total += last - first;
+        if (use_cachestat) {
+            CachestatRange range = {(uint64_t)(first * page), (uint64_t)((last - first) * page)};
+            Cachestat cs = {};
+            if (syscall(__NR_cachestat, fd, &range, &cs, 0) == 0) {
+                r.cached += (long long)cs.nr_cache;
+                r.dirty += (long long)cs.nr_dirty;
+                return;
+            }
+            if (errno == ENOSYS) use_cachestat = false;
+        }
+        r.method = "mincore";
+        if (last == first) return;
+        void* map = mmap(nullptr, (size_t)((last - first) * page), PROT_READ, MAP_SHARED, fd, first * page);
+        if (map == MAP_FAILED) return;
+        std::vector<unsigned char> resident((size_t)(last - first));
+        if (mincore(map, (size_t)((last - first) * page), resident.data()) == 0) {
+            for (unsigned char page_state : resident) r.cached += page_state & 1;
+        }
+        munmap(map, (size_t)((last - first) * page));
+    }
+
+    std::string mode = "keep";
+    double warm_fraction = 0;
+    mutable bool use_cachestat = true;
+};
@@ -0,0 +1,176 @@
+#pragma once
+
+// Keep-open file descriptors for the read loops, the native counterpart of
+// FileManagerNoEvictionNoOpen.fd_map in file_manager.py. Files are opened on
+// first use and stay open; with a capacity the least recently used idle fd is
+// closed to make room. An fd is pinned while a reader holds it, so eviction
+// never closes a file that still has reads outstanding. Readers share one fd
+// per file and must therefore use pread() at explicit offsets.
+
+#include <sys/resource.h>
+#include <unistd.h>
+#include <cerrno>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class FdCache {
+public:
+    // `capacity` 0 means no limit; `open_file` returns an fd or -1
+    FdCache(size_t capacity, std::function<int(int)> open_file)
+        : capacity(capacity), open_file(std::move(open_file)) {}
+
+    ~FdCache() { close_all(); }
+
+    FdCache(const FdCache&) = delete;
+    FdCache& operator=(const FdCache&) = delete;
+
+    // Returns an open fd for `file_num` and pins it, or -1 if it cannot be opened
+    int acquire(int file_num) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = entries.find(file_num);
+            if (it != entries.end()) {
+                it->second.pins++;
+                lru.splice(lru.begin(), lru, it->second.position);
+                hits++;
+                return it->second.fd;
+            }
+        }
+        // Open outside the lock so misses on different files overlap
+        int fd = open_file(file_num);
+        if (fd == -1) {
+            return -1;
+        }
+        std::vector<int> to_close;
+        int result;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = entries.find(file_num);
+            if (it != entries.end()) {
+                // Another reader opened it meanwhile
+                to_close.push_back(fd);
+                it->second.pins++;
+                lru.splice(lru.begin(), lru, it->second.position);
+                result = it->second.fd;
+            } else {
+                lru.push_front(file_num);
+                entries[file_num] = {fd, 1, lru.begin()};
+                result = fd;
+            }
+            misses++;
+            evict_idle(to_close);
+        }
+        for (int stale : to_close) close(stale);
+        return result;
+    }
+
+    // Unpins an fd returned by acquire(); it stays open until evicted
+    void release(int file_num) {
+        std::vector<int> to_close;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = entries.find(file_num);
+            if (it != entries.end() && it->second.pins > 0) {
+                it->second.pins--;
+            }
+            evict_idle(to_close);
+        }
+        for (int stale : to_close) close(stale);
+    }
+
+    // Opens the given files ahead of the measured loop. Returns false on error.
+    bool preload(const std::vector<int>& file_nums) {
+        for (int file_num : file_nums) {
+            if (acquire(file_num) == -1) {
+                return false;
+            }
+            release(file_num);
+        }
+        return true;
+    }
+
+    void close_all() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& entry : entries) {
+            close(entry.second.fd);
+        }
+        entries.clear();
+        lru.clear();
+    }
+
+    void reset_stats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        hits = misses = evictions = 0;
+    }
+
+    void print_stats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        long long lookups = hits + misses;
+        std::cout << "fd cache: " << hits << " hits, " << misses << " misses";
+        if (lookups > 0) std::cout << " (" << (100.0 * hits / lookups) << "% hit rate)";
+        std::cout << ", " << evictions << " evictions, " << entries.size() << " fds open" << std::endl;
+    }
+
+private:
+    struct Entry {
+        int fd;
+        int pins;
+        std::list<int>::iterator position;
+    };
+
+    // Drops least recently used unpinned entries while over capacity. Pinned
+    // entries may keep the cache above capacity until they are released.
+    void evict_idle(std::vector<int>& to_close) {
+        if (capacity == 0) return;
+        auto it = lru.end();
+        while (entries.size() > capacity && it != lru.begin()) {
+            --it;
+            auto entry = entries.find(*it);
+            if (entry->second.pins > 0) continue;
+            to_close.push_back(entry->second.fd);
+            entries.erase(entry);
+            it = lru.erase(it);
+            evictions++;
+        }
+    }
+
+    const size_t capacity;
+    const std::function<int(int)> open_file;
+    mutable std::mutex mutex;
+    std::unordered_map<int, Entry> entries;
+    std::list<int> lru;  // Most recently used first
+    long long hits = 0;
+    long long misses = 0;
+    long long evictions = 0;
+};
+
+// Raises the soft RLIMIT_NOFILE (up to the hard limit) so that `fds` more
+// descriptors fit next to the ones the benchmark already uses. Returns false if
+// the hard limit is too low.
+static inline bool ensure_fd_limit(size_t fds) {
+    const rlim_t RESERVED = 64;  // stdio, io_uring, reader pool, ...
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        return true;
+    }
+    rlim_t needed = (rlim_t)fds + RESERVED;
+    if (limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur < needed) {
+        if (limit.rlim_max != RLIM_INFINITY && limit.rlim_max < needed) {
+            std::cerr << "Error: " << fds << " cached fds exceed the open file limit (hard limit "
+                      << limit.rlim_max << "); use a smaller --fd_cache or raise ulimit -n" << std::endl;
+            return false;
+        }
+        limit.rlim_cur = needed;
+        if (setrlimit(RLIMIT_NOFILE, &limit) != 0) {
+            std::cerr << "Error raising the open file limit to " << needed
+                      << " (errno: " << errno << ")" << std::endl;
+            return false;
+        }
+        std::cout << "Raised open file limit to " << needed << std::endl;
+    }
+    return true;
+}
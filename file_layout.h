@@ -0,0 +1,100 @@
+#pragma once
+
+// Names of the data files under the benchmark directory. The flat layout keeps
+// every file in one directory, PATH/f<i>. The sharded layout spreads them over
+// `levels` levels of `fanout` subdirectories picked by a hash of i, e.g.
+// PATH/3a/7f/f123 for --dir_fanout=256 --dir_levels=2, so no single directory
+// index grows to millions of entries.
+
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct FileLayout {
+    std::string base;   // Directory holding the file set
+    int fanout = 0;     // Subdirectories per level (0 = flat)
+    int levels = 0;
+
+    bool sharded() const { return fanout > 0 && levels > 0; }
+
+    std::string path(long long file_num) const {
+        if (!sharded()) return base + "/f" + std::to_string(file_num);
+        return base + "/" + shard(file_num) + "/f" + std::to_string(file_num);
+    }
+
+    // Subdirectory of `base` holding file `file_num`, e.g. "3a/7f" ("" when flat)
+    std::string shard(long long file_num) const {
+        std::string dir;
+        uint64_t h = mix(file_num);
+        for (int level = 0; level < levels && sharded(); level++) {
+            if (level > 0) dir += "/";
+            dir += digits((int)(h % fanout));
+            h /= fanout;
+        }
+        return dir;
+    }
+
+    // Leaf directories that hold files: just `base` when flat
+    std::vector<std::string> directories() const {
+        std::vector<std::string> dirs = {base};
+        if (!sharded()) return dirs;
+        for (int level = 0; level < levels; level++) {
+            std::vector<std::string> next;
+            next.reserve(dirs.size() * fanout);
+            for (const auto& dir : dirs) {
+                for (int d = 0; d < fanout; d++) next.push_back(dir + "/" + digits(d));
+            }
+            dirs.swap(next);
+        }
+        return dirs;
+    }
+
+    // Creates every shard directory below an existing `base`. Returns false on error.
+    bool create_directories() const {
+        if (!sharded()) return true;
+        std::vector<std::string> dirs = {base};
+        for (int level = 0; level < levels; level++) {
+            std::vector<std::string> next;
+            for (const auto& dir : dirs) {
+                for (int d = 0; d < fanout; d++) {
+                    std::string sub = dir + "/" + digits(d);
+                    if (mkdir(sub.c_str(), 0755) != 0 && errno != EEXIST) {
+                        std::cerr << "Error creating directory " << sub << " (errno: " << errno << ")" << std::endl;
+                        return false;
+                    }
+                    next.push_back(sub);
+                }
+            }
+            dirs.swap(next);
+        }
+        return true;
+    }
+
+    long long num_directories() const {
+        long long count = 1;
+        for (int level = 0; level < levels && sharded(); level++) count *= fanout;
+        return count;
+    }
+
+private:
+    // splitmix64 finalizer: neighbouring file numbers land in unrelated directories
+    static uint64_t mix(uint64_t x) {
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    // Fixed-width hex name of subdirectory `d`
+    std::string digits(int d) const {
+        static const char HEX[] = "0123456789abcdef";
+        std::string name;
+        for (int range = fanout - 1; range > 0 || name.empty(); range >>= 4, d >>= 4) {
+            name.insert(name.begin(), HEX[d & 0xf]);
+        }
+        return name;
+    }
+};
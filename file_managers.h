@@ -0,0 +1,510 @@
+#pragma once
+
+// Native port of the file manager strategies in file_manager.py:
+//   kvc2                         one preallocated file, random slot per access
+//   filemanager                  delete a random file + create a new one per write
+//   filemanagernoeviction        rewrite a random existing file per write
+//   filemanagernoevictionnoopen  like noeviction, but every file stays open
+// Each read/write call does the same syscalls as the Python method it mirrors,
+// without the GIL and executor overhead in between.
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "file_layout.h"
+#include "random_pop_pool.h"
+#include "rate_limiter.h"
+
+struct ManagerConfig {
+    std::string base_path;
+    int num_files;
+    long long file_size;
+    int num_workers;             // Reads (and follow-up writes) per request
+    int max_write_waiters;       // Concurrent writes allowed by the write semaphore
+    int max_inflight_requests;
+    bool o_direct;               // Open data files with O_DIRECT
+    bool lock_free_pool;         // File checkout through ShardedRandomPopPool instead of one lock
+    RateLimiter* rate_limiter;   // Optional, shared with the caller
+    FileLayout layout;           // Names of the data files under base_path (flat or sharded)
+};
+
+// One write between prepare_write() and complete_write(): the data transfer
+// itself (io_size bytes of the manager's write buffer at `offset` of `fd`) is
+// left to the caller, so a writer stage can submit several of them at once
+struct PendingWrite {
+    int fd = -1;
+    off_t offset = 0;
+    int file_id = -1;
+    std::string name;             // For messages
+};
+
+// Counting semaphore, the equivalent of threading.BoundedSemaphore
+class Semaphore {
+public:
+    explicit Semaphore(int initial) : count(initial) {}
+
+    void acquire() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return count > 0; });
+        count--;
+    }
+
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            count++;
+        }
+        cv.notify_one();
+    }
+
+    int value() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return count;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    int count;
+};
+
+class BaseFileManager {
+public:
+    explicit BaseFileManager(const ManagerConfig& cfg)
+        : cfg(cfg), write_semaphore(cfg.max_write_waiters) {}
+    virtual ~BaseFileManager() { free(dummy_buf); }
+
+    // Prepares the directory and the file set. Returns false on error.
+    virtual bool init(bool recreate_dir) {
+        // O_DIRECT transfers must cover whole 4 KB blocks of an aligned buffer
+        io_size = cfg.o_direct ? (cfg.file_size + 4095) / 4096 * 4096 : cfg.file_size;
+        void* raw;
+        if (posix_memalign(&raw, 4096, io_size > 0 ? io_size : 4096) != 0) {
+            std::cerr << "Error allocating manager buffer" << std::endl;
+            return false;
+        }
+        dummy_buf = static_cast<char*>(raw);
+        memset(dummy_buf, 0xab, io_size);
+        if (recreate_dir) {
+            try {
+                if (std::filesystem::exists(cfg.base_path)) {
+                    std::filesystem::remove_all(cfg.base_path);
+                }
+                std::filesystem::create_directories(cfg.base_path);
+            } catch (const std::exception& e) {
+                std::cerr << "Error recreating directory: " << e.what() << std::endl;
+                return false;
+            }
+            if (!cfg.layout.create_directories()) return false;
+        }
+        return true;
+    }
+
+    // One write under the write semaphore, done on the calling thread
+    bool write_kv_single_file(int worker_id, bool to_delete) {
+        write_semaphore.acquire();
+        PendingWrite write;
+        bool ok = prepare_write(worker_id, to_delete, write);
+        if (ok) {
+            ok = write_full(write.fd, write.offset, write.name);
+            complete_write(write, ok);
+        }
+        write_semaphore.release();
+        return ok;
+    }
+
+    // Picks the target of a write and opens it (everything but the transfer).
+    // Returns false on error, with nothing left to complete.
+    virtual bool prepare_write(int worker_id, bool to_delete, PendingWrite& write) = 0;
+    // Releases what prepare_write() took once the transfer finished (`ok`) or failed
+    virtual void complete_write(const PendingWrite& write, bool ok) = 0;
+    virtual bool read_kv_single_file(int worker_id) = 0;
+
+    const char* write_data() const { return dummy_buf; }
+    size_t write_size() const { return io_size; }
+
+    void sync_wait_for_place_in_write_queue() {
+        write_semaphore.acquire();
+        write_semaphore.release();
+    }
+
+    int write_semaphore_value() { return write_semaphore.value(); }
+
+protected:
+    void throttle(bool is_read) {
+        if (cfg.rate_limiter) {
+            cfg.rate_limiter->wait_for_allowance(cfg.file_size, is_read);
+        }
+    }
+
+    int data_flags() const { return cfg.o_direct ? O_DIRECT : 0; }
+
+    bool write_full(int fd, off_t offset, const std::string& what) {
+        ssize_t written = pwrite(fd, dummy_buf, io_size, offset);
+        if (written != (ssize_t)io_size) {
+            std::cerr << "Error writing " << what << " (errno: " << errno << ")" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool read_full(int fd, off_t offset, char* buffer, const std::string& what) {
+        ssize_t bytes_read = pread(fd, buffer, io_size, offset);
+        if (bytes_read < 0) {
+            std::cerr << "Error reading " << what << " (errno: " << errno << ")" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Per-thread aligned buffer that reads land in
+    char* read_buffer() {
+        static thread_local std::unique_ptr<char, decltype(&free)> buffer(nullptr, &free);
+        static thread_local size_t buffer_size = 0;
+        if (buffer_size < io_size) {
+            void* raw;
+            if (posix_memalign(&raw, 4096, io_size) != 0) {
+                return nullptr;
+            }
+            buffer.reset(static_cast<char*>(raw));
+            buffer_size = io_size;
+        }
+        return buffer.get();
+    }
+
+    ManagerConfig cfg;
+    Semaphore write_semaphore;
+    char* dummy_buf = nullptr;
+    size_t io_size = 0;
+};
+
+class KVC2 : public BaseFileManager {
+public:
+    using BaseFileManager::BaseFileManager;
+
+    ~KVC2() override {
+        for (int fd : fd_queue) close(fd);
+    }
+
+    bool init(bool recreate_dir) override {
+        if (!BaseFileManager::init(recreate_dir)) return false;
+        kvc2_file_path = cfg.base_path + "/kvc2";
+        int fd = open(kvc2_file_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | data_flags(), 0644);
+        if (fd == -1) {
+            std::cerr << "Error creating " << kvc2_file_path << " (errno: " << errno << ")" << std::endl;
+            return false;
+        }
+        for (int i = 0; i < cfg.num_files; i++) {
+            if (!write_full(fd, (off_t)i * io_size, kvc2_file_path)) {
+                close(fd);
+                return false;
+            }
+        }
+        close(fd);
+        int num_fds = (cfg.max_inflight_requests + cfg.max_write_waiters) * cfg.num_workers;
+        for (int i = 0; i < num_fds; i++) {
+            fd = open(kvc2_file_path.c_str(), O_RDWR | data_flags());
+            if (fd == -1) {
+                std::cerr << "Error opening " << kvc2_file_path << " (errno: " << errno << ")" << std::endl;
+                return false;
+            }
+            fd_queue.push_back(fd);
+        }
+        return true;
+    }
+
+    bool prepare_write(int worker_id, bool to_delete, PendingWrite& write) override {
+        (void)worker_id;
+        (void)to_delete;
+        write.fd = get_fd();
+        write.offset = random_block_offset();
+        write.name = kvc2_file_path;
+        throttle(false);
+        return true;
+    }
+
+    void complete_write(const PendingWrite& write, bool ok) override {
+        (void)ok;
+        put_fd(write.fd);
+    }
+
+    bool read_kv_single_file(int worker_id) override {
+        (void)worker_id;
+        char* buffer = read_buffer();
+        if (!buffer) return false;
+        int fd = get_fd();
+        throttle(true);
+        bool ok = read_full(fd, random_block_offset(), buffer, kvc2_file_path);
+        put_fd(fd);
+        return ok;
+    }
+
+private:
+    off_t random_block_offset() {
+        std::uniform_int_distribution<int> dist(0, cfg.num_files - 1);
+        return (off_t)dist(manager_rng()) * io_size;
+    }
+
+    int get_fd() {
+        std::unique_lock<std::mutex> lock(fd_mutex);
+        fd_available.wait(lock, [this] { return !fd_queue.empty(); });
+        int fd = fd_queue.back();
+        fd_queue.pop_back();
+        return fd;
+    }
+
+    void put_fd(int fd) {
+        {
+            std::lock_guard<std::mutex> lock(fd_mutex);
+            fd_queue.push_back(fd);
+        }
+        fd_available.notify_one();
+    }
+
+    std::string kvc2_file_path;
+    std::mutex fd_mutex;
+    std::condition_variable fd_available;
+    std::vector<int> fd_queue;
+};
+
+class FileManager : public BaseFileManager {
+public:
+    explicit FileManager(const ManagerConfig& cfg)
+        : BaseFileManager(cfg), files(make_random_pop_pool(cfg.lock_free_pool, cfg.num_files)) {}
+
+    bool init(bool recreate_dir) override {
+        if (!BaseFileManager::init(recreate_dir)) return false;
+        if (recreate_dir) {
+            for (int i = 0; i < cfg.num_files; i++) {
+                if (!create_initial_file()) return false;
+            }
+            return true;
+        }
+        // Sharded layouts keep the files in the leaf directories only
+        int max_id = -1;
+        for (const std::string& dir_path : cfg.layout.directories()) {
+            DIR* dir = opendir(dir_path.c_str());
+            if (!dir) {
+                std::cerr << "Error opening directory " << dir_path << std::endl;
+                return false;
+            }
+            struct dirent* entry;
+            while ((entry = readdir(dir)) != nullptr) {
+                std::string name = entry->d_name;
+                if (name == "." || name == "..") continue;
+                if (name.size() < 2 || name[0] != 'f' ||
+                    name.find_first_not_of("0123456789", 1) != std::string::npos) {
+                    std::cerr << "Invalid file format: " << name << std::endl;
+                    closedir(dir);
+                    return false;
+                }
+                if (files->size() == cfg.num_files) {
+                    std::cerr << "More than " << cfg.num_files << " files in " << cfg.base_path << std::endl;
+                    closedir(dir);
+                    return false;
+                }
+                int file_id = std::stoi(name.substr(1));
+                if (file_id > max_id) max_id = file_id;
+                add_file(file_id);
+            }
+            closedir(dir);
+        }
+        next_id = max_id + 1;
+        return true;
+    }
+
+    bool prepare_write(int worker_id, bool to_delete, PendingWrite& write) override {
+        (void)worker_id;
+        if (to_delete) {
+            std::string file_name_to_delete = file_name(pop_random_file());
+            if (unlink(file_name_to_delete.c_str()) != 0) {
+                std::cerr << "Error deleting " << file_name_to_delete << " (errno: " << errno << ")" << std::endl;
+                return false;
+            }
+        }
+        write.file_id = create_file_id();
+        throttle(false);
+        return open_new_file(write);
+    }
+
+    void complete_write(const PendingWrite& write, bool ok) override {
+        close(write.fd);
+        if (ok) add_file(write.file_id);
+    }
+
+    bool read_kv_single_file(int worker_id) override {
+        (void)worker_id;
+        char* buffer = read_buffer();
+        if (!buffer) return false;
+        int file_id = pop_random_file();
+        throttle(true);
+        std::string name = file_name(file_id);
+        int fd = open(name.c_str(), O_RDONLY | data_flags());
+        if (fd == -1) {
+            std::cerr << "Error opening " << name << " (errno: " << errno << ")" << std::endl;
+            add_file(file_id);
+            return false;
+        }
+        bool ok = read_full(fd, 0, buffer, name);
+        close(fd);
+        add_file(file_id);
+        return ok;
+    }
+
+protected:
+    std::string file_name(int file_id) const {
+        return cfg.layout.path(file_id);
+    }
+
+    int create_file_id() {
+        return next_id++;
+    }
+
+    // The open(name, 'wb') half of Python's open + write: create or truncate
+    bool open_new_file(PendingWrite& write) {
+        write.name = file_name(write.file_id);
+        write.offset = 0;
+        write.fd = open(write.name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | data_flags(), 0644);
+        if (write.fd == -1) {
+            std::cerr << "Error creating " << write.name << " (errno: " << errno << ")" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool write_new_file(int file_id) {
+        PendingWrite write;
+        write.file_id = file_id;
+        if (!open_new_file(write)) return false;
+        bool ok = write_full(write.fd, 0, write.name);
+        close(write.fd);
+        return ok;
+    }
+
+    bool create_initial_file() {
+        int file_id = create_file_id();
+        if (!write_new_file(file_id)) return false;
+        add_file(file_id);
+        return true;
+    }
+
+    // Exclusive checkout of a random file; waits if every file is checked out
+    int pop_random_file() {
+        return files->pop();
+    }
+
+    void add_file(int file_id) {
+        files->add(file_id);
+    }
+
+    std::unique_ptr<RandomPopPool> files;
+    std::atomic<int> next_id{0};
+};
+
+class FileManagerNoEviction : public FileManager {
+public:
+    using FileManager::FileManager;
+
+    bool prepare_write(int worker_id, bool to_delete, PendingWrite& write) override {
+        (void)worker_id;
+        (void)to_delete;
+        write.file_id = pop_random_file();
+        throttle(false);
+        if (!open_new_file(write)) {
+            add_file(write.file_id);
+            return false;
+        }
+        return true;
+    }
+
+    void complete_write(const PendingWrite& write, bool ok) override {
+        (void)ok;
+        close(write.fd);
+        add_file(write.file_id);
+    }
+};
+
+class FileManagerNoEvictionNoOpen : public FileManagerNoEviction {
+public:
+    using FileManagerNoEviction::FileManagerNoEviction;
+
+    ~FileManagerNoEvictionNoOpen() override {
+        for (auto& entry : fd_map) close(entry.second);
+    }
+
+    bool init(bool recreate_dir) override {
+        if (!FileManagerNoEviction::init(recreate_dir)) return false;
+        // Every file is opened once here; reads and writes only pread/pwrite
+        std::vector<int> file_list;
+        while (files->size() > 0) {
+            int file_id = files->pop();
+            file_list.push_back(file_id);
+            std::string name = file_name(file_id);
+            int fd = open(name.c_str(), O_RDWR | data_flags());
+            if (fd == -1) {
+                std::cerr << "Error opening " << name << " (errno: " << errno << ")" << std::endl;
+                return false;
+            }
+            fd_map[file_id] = fd;
+        }
+        for (int file_id : file_list) {
+            files->add(file_id);
+        }
+        return true;
+    }
+
+    bool prepare_write(int worker_id, bool to_delete, PendingWrite& write) override {
+        (void)worker_id;
+        (void)to_delete;
+        write.file_id = pop_random_file();
+        write.fd = fd_map.at(write.file_id);
+        write.offset = 0;
+        write.name = file_name(write.file_id);
+        throttle(false);
+        return true;
+    }
+
+    void complete_write(const PendingWrite& write, bool ok) override {
+        (void)ok;
+        add_file(write.file_id);
+    }
+
+    bool read_kv_single_file(int worker_id) override {
+        (void)worker_id;
+        char* buffer = read_buffer();
+        if (!buffer) return false;
+        int file_id = pop_random_file();
+        throttle(true);
+        bool ok = read_full(fd_map.at(file_id), 0, buffer, file_name(file_id));
+        add_file(file_id);
+        return ok;
+    }
+
+private:
+    // Written only during init(), read concurrently afterwards
+    std::unordered_map<int, int> fd_map;
+};
+
+// Returns nullptr for an unknown manager name
+static inline std::unique_ptr<BaseFileManager> make_file_manager(const std::string& type,
+                                                                 const ManagerConfig& cfg) {
+    if (type == "kvc2") return std::make_unique<KVC2>(cfg);
+    if (type == "filemanager") return std::make_unique<FileManager>(cfg);
+    if (type == "filemanagernoeviction") return std::make_unique<FileManagerNoEviction>(cfg);
+    if (type == "filemanagernoevictionnoopen") return std::make_unique<FileManagerNoEvictionNoOpen>(cfg);
+    return nullptr;
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+// Device-level I/O accounting next to the application's own byte counts. The
+// block device behind PATH is found through its st_dev; its counters come from
+// /sys/dev/block/<major>:<minor>/stat (or the matching /proc/diskstats line),
+// the process counters from /proc/self/io, CPU time from getrusage() and
+// /proc/stat. Comparing the bytes a loop asked
+// for with the bytes the device actually moved separates page-cache hits,
+// readahead and silent O_DIRECT fallbacks from real device I/O; the CPU time
+// shows what a polling mode costs for the latency it saves.
+
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Counters of one snapshot, or the difference of two
+struct IoCounters {
+    bool device = false;       // Device fields are valid
+    long long read_ios = 0;
+    long long read_merges = 0;
+    long long read_bytes = 0;
+    long long read_ms = 0;     // Time spent on reads, summed over all reads
+    long long write_ios = 0;
+    long long write_merges = 0;
+    long long write_bytes = 0;
+    long long write_ms = 0;
+    long long busy_ms = 0;     // Time with at least one I/O in flight (io_ticks)
+    long long queue_ms = 0;    // Weighted time in queue (time_in_queue)
+    long long proc_read_bytes = 0;   // /proc/self/io: bytes this process caused to be read from storage
+    long long proc_write_bytes = 0;
+    long long proc_rchar = 0;        // /proc/self/io: bytes passed to read() and friends
+    long long proc_wchar = 0;
+    long long cpu_user_us = 0;       // getrusage(RUSAGE_SELF): every thread of the process
+    long long cpu_sys_us = 0;
+    long long host_busy_ticks = 0;   // /proc/stat: all CPUs, including kernel threads polling for us
+    long long host_total_ticks = 0;
+
+    IoCounters operator-(const IoCounters& before) const {
+        IoCounters d;
+        d.device = device && before.device;
+        d.read_ios = read_ios - before.read_ios;
+        d.read_merges = read_merges - before.read_merges;
+        d.read_bytes = read_bytes - before.read_bytes;
+        d.read_ms = read_ms - before.read_ms;
+        d.write_ios = write_ios - before.write_ios;
+        d.write_merges = write_merges - before.write_merges;
+        d.write_bytes = write_bytes - before.write_bytes;
+        d.write_ms = write_ms - before.write_ms;
+        d.busy_ms = busy_ms - before.busy_ms;
+        d.queue_ms = queue_ms - before.queue_ms;
+        d.proc_read_bytes = proc_read_bytes - before.proc_read_bytes;
+        d.proc_write_bytes = proc_write_bytes - before.proc_write_bytes;
+        d.proc_rchar = proc_rchar - before.proc_rchar;
+        d.proc_wchar = proc_wchar - before.proc_wchar;
+        d.cpu_user_us = cpu_user_us - before.cpu_user_us;
+        d.cpu_sys_us = cpu_sys_us - before.cpu_sys_us;
+        d.host_busy_ticks = host_busy_ticks - before.host_busy_ticks;
+        d.host_total_ticks = host_total_ticks - before.host_total_ticks;
+        return d;
+    }
+
+    // Adds the difference `run` of another interval, e.g. to total several runs
+    IoCounters& operator+=(const IoCounters& run) {
+        device = device && run.device;
+        read_ios += run.read_ios;
+        read_merges += run.read_merges;
+        read_bytes += run.read_bytes;
+        read_ms += run.read_ms;
+        write_ios += run.write_ios;
+        write_merges += run.write_merges;
+        write_bytes += run.write_bytes;
+        write_ms += run.write_ms;
+        busy_ms += run.busy_ms;
+        queue_ms += run.queue_ms;
+        proc_read_bytes += run.proc_read_bytes;
+        proc_write_bytes += run.proc_write_bytes;
+        proc_rchar += run.proc_rchar;
+        proc_wchar += run.proc_wchar;
+        cpu_user_us += run.cpu_user_us;
+        cpu_sys_us += run.cpu_sys_us;
+        host_busy_ticks += run.host_busy_ticks;
+        host_total_ticks += run.host_total_ticks;
+        return *this;
+    }
+};
+
+class IoAccounting {
+public:
+    // Finds the block device holding `path`. Returns false if there is none
+    // (tmpfs, overlay, NFS, ...); snapshots then carry process counters only.
+    // A block device node (a raw slab) is accounted as itself, and a path that
+    // does not exist yet through its directory.
+    bool init(const std::string& path) {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) {
+            size_t slash = path.rfind('/');
+            std::string parent = (slash == std::string::npos) ? "." : path.substr(0, slash);
+            if (stat(parent.c_str(), &st) != 0) return false;
+        }
+        dev_t dev_id = S_ISBLK(st.st_mode) ? st.st_rdev : st.st_dev;
+        if (major(dev_id) == 0) {
+            return false;
+        }
+        dev_major = major(dev_id);
+        dev_minor = minor(dev_id);
+        std::string dev = std::to_string(dev_major) + ":" + std::to_string(dev_minor);
+        sys_stat = "/sys/dev/block/" + dev + "/stat";
+        std::ifstream uevent("/sys/dev/block/" + dev + "/uevent");
+        std::string line;
+        while (std::getline(uevent, line)) {
+            if (line.rfind("DEVNAME=", 0) == 0) device_name = line.substr(8);
+        }
+        if (device_name.empty()) device_name = dev;
+        IoCounters probe;
+        if (!read_device(probe)) {
+            sys_stat.clear();
+            return false;
+        }
+        return true;
+    }
+
+    const std::string& device() const { return device_name; }
+
+    IoCounters snapshot() const {
+        IoCounters c;
+        c.device = !sys_stat.empty() && read_device(c);
+        std::ifstream io("/proc/self/io");
+        std::string name;
+        long long value;
+        while (io >> name >> value) {
+            if (name == "read_bytes:") c.proc_read_bytes = value;
+            if (name == "write_bytes:") c.proc_write_bytes = value;
+            if (name == "rchar:") c.proc_rchar = value;
+            if (name == "wchar:") c.proc_wchar = value;
+        }
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0) {
+            c.cpu_user_us = (long long)usage.ru_utime.tv_sec * 1000000 + usage.ru_utime.tv_usec;
+            c.cpu_sys_us = (long long)usage.ru_stime.tv_sec * 1000000 + usage.ru_stime.tv_usec;
+        }
+        // cpu  user nice system idle iowait irq softirq steal ...
+        std::ifstream stat("/proc/stat");
+        std::string cpu;
+        long long ticks[8] = {};
+        if (stat >> cpu && cpu == "cpu") {
+            for (long long& t : ticks) stat >> t;
+            c.host_total_ticks = ticks[0] + ticks[1] + ticks[2] + ticks[3] + ticks[4] + ticks[5] + ticks[6] + ticks[7];
+            c.host_busy_ticks = c.host_total_ticks - ticks[3] - ticks[4];
+        }
+        return c;
+    }
+
+    // Prints what the device and the kernel saw during a phase of `seconds`
+    // in which the loops themselves moved `app_bytes`
+    void print(const IoCounters& d, long long app_bytes, double seconds) const {
+        const double MB = 1024.0 * 1024.0;
+        if (seconds <= 0) seconds = 1e-9;
+        std::cout << "I/O accounting: application " << app_bytes << " bytes; process storage read "
+                  << d.proc_read_bytes << ", write " << d.proc_write_bytes << " bytes (rchar " << d.proc_rchar
+                  << ", wchar " << d.proc_wchar << ")" << std::endl;
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        std::cout << "CPU: process user " << d.cpu_user_us / 1000.0 << " ms, sys " << d.cpu_sys_us / 1000.0 
+                  << " ms (" << (d.cpu_user_us + d.cpu_sys_us) / (seconds * 1e4) << "% of one core); host busy "
+                  << (d.host_total_ticks > 0 ? 100.0 * d.host_busy_ticks / d.host_total_ticks : 0) << "% of "
+                  << cpus << " CPUs" << std::endl;
+        if (!d.device) return;
+        std::cout << "Device " << device_name << ": reads " << d.read_ios << " (" << (d.read_ios / seconds)
+                  << " IOPS, " << (d.read_bytes / seconds / MB) << " MB/s, " << d.read_merges << " merged, "
+                  << (d.read_ios > 0 ? (double)d.read_ms / d.read_ios : 0) << " ms avg), writes " << d.write_ios
+                  << " (" << (d.write_ios / seconds) << " IOPS, " << (d.write_bytes / seconds / MB) << " MB/s, "
+                  << d.write_merges << " merged, " << (d.write_ios > 0 ? (double)d.write_ms / d.write_ios : 0)
+                  << " ms avg), " << (100.0 * d.busy_ms / (seconds * 1000.0)) << "% busy, avg queue "
+                  << (d.queue_ms / (seconds * 1000.0)) << std::endl;
+        long long device_bytes = d.read_bytes + d.write_bytes;
+        if (app_bytes > 0) {
+            std::cout << "Device bytes per application byte: " << (double)device_bytes / app_bytes
+                      << " (device-wide, includes other processes)" << std::endl;
+        }
+    }
+
+private:
+    // Parses the 11 leading fields of a block stat line into `c`
+    static bool parse_stat(std::istream& in, IoCounters& c) {
+        long long read_sectors, write_sectors, in_flight;
+        if (!(in >> c.read_ios >> c.read_merges >> read_sectors >> c.read_ms >> c.write_ios >> c.write_merges
+                 >> write_sectors >> c.write_ms >> in_flight >> c.busy_ms >> c.queue_ms)) {
+            return false;
+        }
+        // The stat files count 512-byte sectors whatever the device's block size
+        c.read_bytes = read_sectors * 512;
+        c.write_bytes = write_sectors * 512;
+        return true;
+    }
+
+    bool read_device(IoCounters& c) const {
+        std::ifstream sys(sys_stat);
+        if (sys && parse_stat(sys, c)) return true;
+        std::ifstream diskstats("/proc/diskstats");
+        std::string line;
+        while (std::getline(diskstats, line)) {
+            std::istringstream fields(line);
+            unsigned int line_major, line_minor;
+            std::string name;
+            if (fields >> line_major >> line_minor >> name && line_major == dev_major && line_minor == dev_minor) {
+                return parse_stat(fields, c);
+            }
+        }
+        return false;
+    }
+
+    unsigned int dev_major = 0;
+    unsigned int dev_minor = 0;
+    std::string sys_stat;
+    std::string device_name;
+};
@@ -0,0 +1,148 @@
+#pragma once
+
+// HDR-style log-linear latency histogram. Values are nanoseconds; every power
+// of two is split into 32 linear sub-buckets, which bounds the relative error
+// of a reported percentile to ~3% while keeping recording to a few integer ops.
+// A histogram has a single writer (one per thread); merge() them after the
+// threads are joined, so the hot path needs no locks or atomics.
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BITS = 5;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+    static constexpr int MAX_SHIFT = 40;  // Values of 2^46 ns (~19.5 hours) and above are clamped
+    static constexpr int NUM_BUCKETS = (MAX_SHIFT + 2) * SUB_BUCKETS;
+
+    void record(uint64_t ns) {
+        counts[bucket_index(ns)]++;
+        total_count++;
+        total_ns += ns;
+        if (ns > max_value) max_value = ns;
+        if (ns < min_value) min_value = ns;
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (int i = 0; i < NUM_BUCKETS; i++) {
+            counts[i] += other.counts[i];
+        }
+        total_count += other.total_count;
+        total_ns += other.total_ns;
+        if (other.max_value > max_value) max_value = other.max_value;
+        if (other.min_value < min_value) min_value = other.min_value;
+    }
+
+    void reset() { *this = LatencyHistogram(); }
+
+    // Bucket that holds `ns`, for recorders that keep their own bucket counts
+    static int bucket_of(uint64_t ns) { return bucket_index(ns); }
+
+    // Adds `n` samples of bucket `index`, valued at the bucket's midpoint
+    void record_bucket(int index, uint64_t n) {
+        if (n == 0) return;
+        counts[index] += n;
+        total_count += n;
+        total_ns += n * ((bucket_low(index) + bucket_high(index)) / 2);
+        if (bucket_high(index) > max_value) max_value = bucket_high(index);
+        if (bucket_low(index) < min_value) min_value = bucket_low(index);
+    }
+
+    uint64_t count() const { return total_count; }
+    uint64_t max_ns() const { return max_value; }
+    uint64_t min_ns() const { return total_count > 0 ? min_value : 0; }
+    double mean_ns() const { return total_count > 0 ? (double)total_ns / total_count : 0; }
+
+    // Value at percentile p (0..100): the midpoint of the bucket that holds it,
+    // clamped to the exact observed min/max
+    uint64_t percentile_ns(double p) const {
+        if (total_count == 0) return 0;
+        uint64_t rank = (uint64_t)(p / 100.0 * total_count + 0.5);
+        if (rank < 1) rank = 1;
+        if (rank > total_count) rank = total_count;
+        uint64_t seen = 0;
+        for (int i = 0; i < NUM_BUCKETS; i++) {
+            seen += counts[i];
+            if (seen >= rank) {
+                uint64_t value = (bucket_low(i) + bucket_high(i)) / 2;
+                if (value > max_value) value = max_value;
+                if (value < min_value) value = min_value;
+                return value;
+            }
+        }
+        return max_value;
+    }
+
+private:
+    static int bucket_index(uint64_t ns) {
+        if (ns < 2 * SUB_BUCKETS) {
+            return (int)ns;
+        }
+        int msb = 63 - __builtin_clzll(ns);
+        int shift = msb - SUB_BITS;
+        if (shift > MAX_SHIFT) {
+            return NUM_BUCKETS - 1;
+        }
+        return shift * SUB_BUCKETS + (int)(ns >> shift);
+    }
+
+    static uint64_t bucket_low(int index) {
+        if (index < 2 * SUB_BUCKETS) {
+            return index;
+        }
+        int shift = index / SUB_BUCKETS - 1;
+        return (uint64_t)(index - shift * SUB_BUCKETS) << shift;
+    }
+
+    static uint64_t bucket_high(int index) {
+        if (index < 2 * SUB_BUCKETS) {
+            return index;
+        }
+        int shift = index / SUB_BUCKETS - 1;
+        return (((uint64_t)(index - shift * SUB_BUCKETS) + 1) << shift) - 1;
+    }
+
+    std::array<uint64_t, NUM_BUCKETS> counts{};
+    uint64_t total_count = 0;
+    uint64_t total_ns = 0;
+    uint64_t max_value = 0;
+    uint64_t min_value = UINT64_MAX;
+};
+
+// Latencies of the phases of one file access
+struct PhaseHistograms {
+    LatencyHistogram open;
+    LatencyHistogram map;    // mmap() + madvise() on the mmap engine
+    LatencyHistogram read;
+    LatencyHistogram write;
+    LatencyHistogram sync;   // fdatasync() on the write path
+    LatencyHistogram close;
+    LatencyHistogram file;   // open through close
+    LatencyHistogram scheduled;  // --workload=replay: intended start through completion
+
+    void merge(const PhaseHistograms& other) {
+        open.merge(other.open);
+        map.merge(other.map);
+        read.merge(other.read);
+        write.merge(other.write);
+        sync.merge(other.sync);
+        close.merge(other.close);
+        file.merge(other.file);
+        scheduled.merge(other.scheduled);
+    }
+
+    // Phases that recorded at least one sample, in access order
+    std::vector<std::pair<const char*, const LatencyHistogram*>> recorded() const {
+        std::vector<std::pair<const char*, const LatencyHistogram*>> phases;
+        const std::pair<const char*, const LatencyHistogram*> all[] = {
+            {"open", &open}, {"map", &map}, {"read", &read}, {"write", &write}, {"sync", &sync},
+            {"close", &close}, {"file", &file}, {"scheduled", &scheduled}};
+        for (const auto& phase : all) {
+            if (phase.second->count() > 0) phases.push_back(phase);
+        }
+        return phases;
+    }
+};
@@ -1,10 +1,16 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <filesystem>
 #include <chrono>
+#include <climits>
+#include <cmath>
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <cstdlib>
 #include <cerrno>
@@ -12,9 +18,1520 @@
 #include <random>
 #include <thread>
 #include <atomic>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <shared_mutex>
+#include <memory>
+
+#include "affinity.h"
+#include "buffer_arena.h"
+#include "cache_control.h"
+#include "fd_cache.h"
+#include "file_layout.h"
+#include "file_managers.h"
+#include "io_accounting.h"
+#include "latency_histogram.h"
+#include "path_table.h"
+#include "populate.h"
+#include "rate_limiter.h"
+#include "sampler.h"
+#include "reader_pool.h"
+#include "report.h"
+#include "slab.h"
+#include "suite.h"
+#include "task_pool.h"
+#include "trace_replay.h"
+#include "uring.h"
+#include "verify.h"
+#include "write_pipeline.h"
+#include "workload.h"
 
 namespace fs = std::filesystem;
 
+static bool parse_bool(const std::string& value) {
+    return value == "1" || value == "true";
+}
+
+// Parses a comma separated list such as "1,4,16"
+static std::vector<int> parse_int_list(const std::string& value) {
+    std::vector<int> result;
+    size_t start = 0;
+    while (start < value.size()) {
+        size_t comma = value.find(',', start);
+        if (comma == std::string::npos) comma = value.size();
+        result.push_back(std::stoi(value.substr(start, comma - start)));
+        start = comma + 1;
+    }
+    return result;
+}
+
+// Named options given as --name=value (or just --name for a boolean flag).
+// Every get_* call consumes the option so leftovers can be reported as unknown.
+struct Options {
+    std::map<std::string, std::string> values;
+    std::vector<std::pair<std::string, std::string>> resolved;  // Every option read, with its effective value
+
+    bool has(const std::string& name) const { return values.count(name) > 0; }
+
+    std::string get(const std::string& name, const std::string& default_value) {
+        auto it = values.find(name);
+        std::string value = (it == values.end()) ? default_value : it->second;
+        if (it != values.end()) values.erase(it);
+        resolved.emplace_back(name, value);
+        return value;
+    }
+
+    long long get_int(const std::string& name, long long default_value) {
+        return std::stoll(get(name, std::to_string(default_value)));
+    }
+
+    bool get_bool(const std::string& name, bool default_value) {
+        return parse_bool(get(name, default_value ? "1" : "0"));
+    }
+};
+
+// Open a file for reading with O_DIRECT, falling back to a buffered open if
+// the filesystem refuses O_DIRECT. Returns -1 if the file cannot be opened.
+static int open_for_read(const std::string& filename) {
+    int fd = open(filename.c_str(), O_RDONLY | O_DIRECT);
+    if (fd == -1) {
+        std::cerr << "Error opening file with O_DIRECT: " << filename 
+                  << " (errno: " << errno << ")" << std::endl;
+        // Try without O_DIRECT as fallback
+        fd = open(filename.c_str(), O_RDONLY);
+        if (fd == -1) {
+            std::cerr << "Error opening file: " << filename << std::endl;
+            return -1;
+        }
+        std::cout << "Warning: O_DIRECT not supported, reading without it" << std::endl;
+    }
+    return fd;
+}
+
+// open_for_read() of file `file_num` through a prebuilt path table
+static int open_for_read(const PathTable& paths, int file_num) {
+    int fd = paths.open(file_num, O_RDONLY | O_DIRECT);
+    if (fd == -1) {
+        std::cerr << "Error opening file with O_DIRECT: " << paths.path(file_num) 
+                  << " (errno: " << errno << ")" << std::endl;
+        fd = paths.open(file_num, O_RDONLY);
+        if (fd == -1) {
+            std::cerr << "Error opening file: " << paths.path(file_num) << std::endl;
+            return -1;
+        }
+        std::cout << "Warning: O_DIRECT not supported, reading without it" << std::endl;
+    }
+    return fd;
+}
+
+using Clock = std::chrono::high_resolution_clock;
+
+// Settings shared by the read and write loops
+struct LoopConfig {
+    FileLayout files;         // Names of f1..fN under PATH (flat or sharded)
+    long long file_size;      // Bytes to read or write per file (aligned_K)
+    size_t chunk_size;        // Bytes per read()/write() / SQE
+    bool skip_read;           // Only open/close
+    bool parallel_read;       // sync engine: split each file across the reader pool
+    int queue_depth;          // io_uring: max chunk reads in flight
+    unsigned uring_setup;     // io_uring: IORING_SETUP_IOPOLL and/or IORING_SETUP_SQPOLL (0 = interrupts)
+    int sqpoll_cpu;           // io_uring: CPU the SQPOLL thread is bound to (-1 = unbound)
+    unsigned sqpoll_idle_ms;  // io_uring: SQPOLL thread spins this long before sleeping
+    RateLimiter* rate_limiter;  // Optional throttling, charged per file before it is opened
+    bool write_workload;      // Measured loop writes files instead of reading them
+    std::string write_variant;  // create, overwrite or prealloc (see sync_write_file)
+    bool write_direct;        // Write with O_DIRECT (false: buffered)
+    bool write_dsync;         // Open for writing with O_DSYNC
+    int fdatasync_every;      // fdatasync() after every Nth write (0 = never)
+    const char* write_buffer;   // chunk_size aligned bytes written to every chunk
+    FdCache* fd_cache;        // Optional keep-open fds for reads (then read with pread)
+    const PathTable* paths;   // Optional prebuilt names that reads open with openat()
+    Slab* slab;               // Optional single-slab layout: file_num selects a slot of the slab
+    bool mmap_read;           // mmap engine: map each file and consume it in place
+    bool map_populate;        // mmap engine: MAP_POPULATE (prefault at mmap time)
+    int madvise_advice;       // mmap engine: madvise() advice, or -1 for none
+    bool huge_pages;          // mmap engine: MADV_HUGEPAGE on the mapping
+    bool touch_all;           // mmap engine: read every word instead of one byte per page
+    BufferArena* arena;       // Source of every chunk_size I/O buffer the loops use
+    IntervalSampler* sampler;  // Optional --sample_ms time series of completed files
+    Verifier* verifier;       // Optional --verify: writes stamp every block, reads check them
+    Clock::time_point deadline;  // --duration: claim no new files after this (default: none)
+    const FileSelector* selector;  // Optional: draw every file from it instead of walking the loop's file list
+};
+
+static double elapsed_us(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+static uint64_t elapsed_ns(Clock::time_point start, Clock::time_point end) {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+// True once a --duration deadline has passed
+static bool out_of_time(const LoopConfig& cfg) {
+    return cfg.deadline != Clock::time_point() && Clock::now() >= cfg.deadline;
+}
+
+// File of iteration `i` of a loop over `files`: the next one in turn, or a
+// fresh draw from cfg.selector when that is set
+static int loop_file(const LoopConfig& cfg, const std::vector<int>& files, long long i) {
+    if (cfg.selector) {
+        static thread_local std::mt19937_64 rng(std::random_device{}());
+        return cfg.selector->next(rng);
+    }
+    return files[i % files.size()];
+}
+
+// Off when --sample_ms reports interval throughput instead
+static bool progress_lines = true;
+
+static void print_progress(long long completed, Clock::time_point start_read) {
+    if (!progress_lines) return;
+    auto current_time = Clock::now();
+    auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(current_time - start_read);
+    double avg_time = elapsed_ms.count() / (double)completed;
+    std::cout << "  Completed " << completed << " iterations, avg time per iteration: " 
+              << avg_time << " ms" << std::endl;
+}
+
+static void print_latency_rows(const std::string& title,
+                               const std::vector<std::pair<const char*, const LatencyHistogram*>>& rows) {
+    std::cout << title << " (us):" << std::endl;
+    std::cout << "  op  count  avg  p50  p90  p99  p99.9  max" << std::endl;
+    for (const auto& row : rows) {
+        const LatencyHistogram& h = *row.second;
+        std::cout << "  " << row.first << "  " << h.count() << "  " << h.mean_ns() / 1000.0 
+                  << "  " << h.percentile_ns(50) / 1000.0 << "  " << h.percentile_ns(90) / 1000.0 
+                  << "  " << h.percentile_ns(99) / 1000.0 << "  " << h.percentile_ns(99.9) / 1000.0 
+                  << "  " << h.max_ns() / 1000.0 << std::endl;
+    }
+}
+
+static void print_latency_table(const PhaseHistograms& hist) {
+    print_latency_rows("Latency per phase", hist.recorded());
+}
+
+// Two-sided 95% critical value of Student's t with `df` degrees of freedom
+static double t_critical_95(int df) {
+    static const double TABLE[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                   2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                   2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    return df <= 30 ? TABLE[df - 1] : 1.96;
+}
+
+// Mean, sample standard deviation and 95% confidence interval of `values` (at least two)
+static void print_repeat_stats(const std::string& metric, const std::vector<double>& values) {
+    double mean = 0;
+    for (double v : values) mean += v;
+    mean /= values.size();
+    double variance = 0;
+    for (double v : values) variance += (v - mean) * (v - mean);
+    double stddev = std::sqrt(variance / (values.size() - 1));
+    double half_width = t_critical_95((int)values.size() - 1) * stddev / std::sqrt((double)values.size());
+    std::cout << "  " << metric << ": mean " << mean << ", stddev " << stddev << ", 95% CI [" 
+              << mean - half_width << ", " << mean + half_width << "] (+/- " 
+              << (mean != 0 ? 100.0 * half_width / mean : 0) << "%)" << std::endl;
+}
+
+// Deadline `seconds` from now, for --duration and --warmup
+static Clock::time_point deadline_after(double seconds) {
+    return Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+// Writes the phase percentiles of each run as JSON. Runs are keyed by files in
+// flight (--inflight depth, or --batch_files for a plain run), plus the chunk
+// size for sweep points.
+static bool write_latency_json(const std::string& json_path, const std::string& engine,
+                               const std::vector<LatencyRun>& runs) {
+    std::ofstream out(json_path);
+    if (!out) {
+        std::cerr << "Error: could not open latency JSON file " << json_path << std::endl;
+        return false;
+    }
+    out << "{\"engine\": \"" << engine << "\", \"unit\": \"us\", \"runs\": [";
+    for (size_t r = 0; r < runs.size(); r++) {
+        const PhaseHistograms& hist = runs[r].hist;
+        out << (r ? ", " : "") << "{\"inflight\": " << runs[r].inflight;
+        if (runs[r].chunk_size > 0) out << ", \"chunk_size\": " << runs[r].chunk_size;
+        out << ", \"phases\": {";
+        bool first = true;
+        for (const auto& phase : hist.recorded()) {
+            const LatencyHistogram& h = *phase.second;
+            out << (first ? "" : ", ") << "\"" << phase.first << "\": {"
+                << "\"count\": " << h.count()
+                << ", \"avg\": " << h.mean_ns() / 1000.0
+                << ", \"min\": " << h.min_ns() / 1000.0
+                << ", \"p50\": " << h.percentile_ns(50) / 1000.0
+                << ", \"p90\": " << h.percentile_ns(90) / 1000.0
+                << ", \"p99\": " << h.percentile_ns(99) / 1000.0
+                << ", \"p99.9\": " << h.percentile_ns(99.9) / 1000.0
+                << ", \"max\": " << h.max_ns() / 1000.0 << "}";
+            first = false;
+        }
+        out << "}}";
+    }
+    out << "]}" << std::endl;
+    if (!out) {
+        std::cerr << "Error writing latency JSON file " << json_path << std::endl;
+        return false;
+    }
+    std::cout << "Latency histograms written to " << json_path << std::endl;
+    return true;
+}
+
+// Opens, reads and closes file `file_num` on the sync engine: sequential read()
+// calls into `read_buffer`, or with parallel_read one pread() per chunk on the
+// pool. With cfg.fd_cache the fd comes from the cache instead of open() and is
+// handed back instead of closed; with cfg.slab it is checked out of the slab's
+// pool and the reads start at the slot offset. Phase latencies go to `hist`.
+// Returns the number of bytes read, or -1 on error.
+static long long sync_read_file(const LoopConfig& cfg, int file_num,
+                                char* read_buffer, ReaderPool& reader_pool, PhaseHistograms& hist) {
+    // Built only for messages when the path table opens the file
+    auto filename = [&] { return cfg.slab ? cfg.slab->name() : cfg.files.path(file_num); };
+    off_t base = cfg.slab ? cfg.slab->slot_offset(file_num) : 0;
+    if (cfg.rate_limiter) {
+        cfg.rate_limiter->wait_for_allowance(cfg.file_size, true);
+    }
+    auto close_file = [&](int fd) {
+        if (cfg.slab) {
+            cfg.slab->put_fd(fd);
+        } else if (cfg.fd_cache) {
+            cfg.fd_cache->release(file_num);
+        } else {
+            close(fd);
+        }
+    };
+    
+    Verifier::ReadCheck check;
+    if (cfg.verifier) check = cfg.verifier->begin_read(file_num);
+    
+    // 1. Open file with O_DIRECT flag
+    auto start_open = Clock::now();
+    int fd = cfg.slab ? cfg.slab->get_fd()
+           : cfg.fd_cache ? cfg.fd_cache->acquire(file_num) : cfg.paths ? open_for_read(*cfg.paths, file_num) : open_for_read(filename());
+    if (fd == -1) {
+        return -1;
+    }
+    auto start_read = Clock::now();
+    
+    // 2. Read all content of the file
+    long long file_total_read = 0;
+    
+    if (!cfg.skip_read) {
+        if (cfg.parallel_read) {
+            // Parallel reading: hand the chunk reads to the pool, the last one
+            // shorter if file_size is not a multiple of chunk_size
+            long long num_chunks = (cfg.file_size + cfg.chunk_size - 1) / cfg.chunk_size;
+            ReadBatch batch;
+            batch.add((int)num_chunks);
+            for (long long chunk_idx = 0; chunk_idx < num_chunks; chunk_idx++) {
+                long long offset = chunk_idx * cfg.chunk_size;
+                size_t len = (size_t)std::min<long long>(cfg.chunk_size, cfg.file_size - offset);
+                reader_pool.submit({fd, base + (off_t)offset, len, &batch});
+            }
+            batch.wait();
+            
+            if (batch.error) {
+                std::cerr << "Error in parallel read of file " << filename() << std::endl;
+                close_file(fd);
+                return -1;
+            }
+            
+            file_total_read = batch.bytes_read.load();
+        } else {
+            // Sequential reading
+            size_t file_remaining = cfg.file_size;
+            while (file_remaining > 0) {
+                size_t to_read = (file_remaining < cfg.chunk_size) ? file_remaining : cfg.chunk_size;
+                
+                // A cached or slab fd is shared, so its file offset cannot be used
+                ssize_t bytes_read = (cfg.fd_cache || cfg.slab)
+                    ? pread(fd, read_buffer, to_read, base + file_total_read)
+                    : read(fd, read_buffer, to_read);
+                if (bytes_read < 0) {
+                    std::cerr << "Error reading file " << filename() 
+                              << " (errno: " << errno << ")" << std::endl;
+                    close_file(fd);
+                    return -1;
+                }
+                if (bytes_read == 0) {
+                    break;  // EOF
+                }
+                if (cfg.verifier) cfg.verifier->check(read_buffer, bytes_read, file_total_read, file_num, check);
+                
+                file_total_read += bytes_read;
+                file_remaining -= bytes_read;
+            }
+        }
+    }
+    
+    if (cfg.verifier && !cfg.skip_read) cfg.verifier->finish(check);
+    
+    // 3. Close file
+    auto start_close = Clock::now();
+    close_file(fd);
+    auto end_close = Clock::now();
+    
+    hist.open.record(elapsed_ns(start_open, start_read));
+    hist.read.record(elapsed_ns(start_read, start_close));
+    hist.close.record(elapsed_ns(start_close, end_close));
+    hist.file.record(elapsed_ns(start_open, end_close));
+    if (cfg.sampler) cfg.sampler->record(elapsed_ns(start_open, end_close), file_total_read);
+    return file_total_read;
+}
+
+// Opens (or recreates) `filename` for sync_write_file according to
+// cfg.write_variant. Returns the fd, or -1 on error.
+static int open_for_write(const LoopConfig& cfg, const std::string& filename) {
+    int flags = O_WRONLY | (cfg.write_dsync ? O_DSYNC : 0);
+    if (cfg.write_variant == "create") {
+        if (unlink(filename.c_str()) != 0 && errno != ENOENT) {
+            std::cerr << "Error deleting file " << filename << " (errno: " << errno << ")" << std::endl;
+            return -1;
+        }
+        flags |= O_CREAT | O_EXCL;
+    } else if (cfg.write_variant == "prealloc") {
+        flags |= O_TRUNC;
+    }
+    int fd = open(filename.c_str(), flags | (cfg.write_direct ? O_DIRECT : 0), 0644);
+    if (fd == -1 && cfg.write_direct && errno == EINVAL) {
+        std::cerr << "Error opening file with O_DIRECT: " << filename 
+                  << " (errno: " << errno << ")" << std::endl;
+        fd = open(filename.c_str(), flags, 0644);
+        if (fd != -1) {
+            std::cout << "Warning: O_DIRECT not supported, writing without it" << std::endl;
+        }
+    }
+    if (fd == -1) {
+        std::cerr << "Error opening file for writing: " << filename 
+                  << " (errno: " << errno << ")" << std::endl;
+        return -1;
+    }
+    return fd;
+}
+
+// Readies `buffer`, a chunk buffer a writing thread took from the arena at
+// setup, as that thread's copy of cfg.write_buffer for --verify to stamp:
+// the shared source buffer itself is never written
+static void fill_stamp_buffer(const LoopConfig& cfg, char* buffer) {
+    if (cfg.verifier && cfg.write_buffer) memcpy(buffer, cfg.write_buffer, cfg.chunk_size);
+}
+
+// Writes one file on the sync engine. Variants of cfg.write_variant:
+//   create     unlink the file, then create it anew and write it (FileManager)
+//   overwrite  rewrite the existing file in place (FileManagerNoEviction without O_TRUNC)
+//   prealloc   truncate, fallocate() the full size, then write into the preallocated extents
+// With cfg.slab only overwrite applies: slot `file_num` is rewritten through a
+// pooled fd. `write_index` counts writes for cfg.fdatasync_every. With
+// --verify the data is stamped in `stamp_buffer`, the calling thread's buffer
+// readied by fill_stamp_buffer. Phase latencies go to `hist` (unlink/fallocate
+// count as open). Returns bytes written, or -1 on error.
+static long long sync_write_file(const LoopConfig& cfg, int file_num, long long write_index,
+                                 char* stamp_buffer, PhaseHistograms& hist) {
+    std::string filename = cfg.slab ? cfg.slab->name() : cfg.files.path(file_num);
+    off_t base = cfg.slab ? cfg.slab->slot_offset(file_num) : 0;
+    if (cfg.rate_limiter) {
+        cfg.rate_limiter->wait_for_allowance(cfg.file_size, false);
+    }
+    auto close_file = [&](int fd) {
+        if (cfg.slab) {
+            cfg.slab->put_fd(fd);
+        } else {
+            close(fd);
+        }
+    };
+    
+    // 1. Open (or recreate) the file
+    auto start_open = Clock::now();
+    int fd = cfg.slab ? cfg.slab->get_fd() : open_for_write(cfg, filename);
+    if (fd == -1) {
+        return -1;
+    }
+    if (cfg.write_variant == "prealloc" && cfg.file_size > 0 && fallocate(fd, 0, 0, cfg.file_size) != 0) {
+        std::cerr << "Error preallocating file " << filename << " (errno: " << errno << ")" << std::endl;
+        close_file(fd);
+        return -1;
+    }
+    
+    // 2. Write all content of the file (--verify: stamped with a new generation)
+    const char* data = cfg.write_buffer;
+    uint64_t generation = 0;
+    if (cfg.verifier) {
+        data = stamp_buffer;
+        generation = cfg.verifier->begin_write();
+    }
+    auto start_write = Clock::now();
+    long long file_total_written = 0;
+    while (file_total_written < cfg.file_size) {
+        size_t to_write = (size_t)std::min<long long>(cfg.chunk_size, cfg.file_size - file_total_written);
+        if (cfg.verifier) {
+            Verifier::stamp(const_cast<char*>(data), to_write, file_total_written, file_num, generation);
+        }
+        ssize_t written = pwrite(fd, data, to_write, base + file_total_written);
+        if (written <= 0) {
+            std::cerr << "Error writing file " << filename << " (errno: " << errno << ")" << std::endl;
+            close_file(fd);
+            return -1;
+        }
+        file_total_written += written;
+    }
+    
+    // 3. Periodic fdatasync
+    auto start_sync = Clock::now();
+    bool synced = cfg.fdatasync_every > 0 && (write_index + 1) % cfg.fdatasync_every == 0;
+    if (synced && fdatasync(fd) != 0) {
+        std::cerr << "Error in fdatasync of " << filename << " (errno: " << errno << ")" << std::endl;
+        close_file(fd);
+        return -1;
+    }
+    
+    if (cfg.verifier) cfg.verifier->end_write(file_num, generation);
+    
+    // 4. Close file
+    auto start_close = Clock::now();
+    close_file(fd);
+    auto end_close = Clock::now();
+    
+    hist.open.record(elapsed_ns(start_open, start_write));
+    hist.write.record(elapsed_ns(start_write, start_sync));
+    if (synced) hist.sync.record(elapsed_ns(start_sync, start_close));
+    hist.close.record(elapsed_ns(start_close, end_close));
+    hist.file.record(elapsed_ns(start_open, end_close));
+    if (cfg.sampler) cfg.sampler->record(elapsed_ns(start_open, end_close), file_total_written);
+    return file_total_written;
+}
+
+// Consumed data of the mmap engine ends up here so the loads are not optimized away
+static volatile uint64_t mmap_sink;
+
+// Maps file `file_num` (or its slab slot) read-only and consumes it in place:
+// one byte per page, which takes every page fault, or with cfg.touch_all a sum
+// over every word as a consumer processing the block would. The fd comes from
+// the slab pool or fd cache like in sync_read_file. Phase latencies go to
+// `hist` (mmap + madvise as map, munmap + close as close). Returns the number
+// of bytes mapped, or -1 on error.
+static long long mmap_read_file(const LoopConfig& cfg, int file_num, PhaseHistograms& hist) {
+    // Built only for messages when the path table opens the file
+    auto filename = [&] { return cfg.slab ? cfg.slab->name() : cfg.files.path(file_num); };
+    off_t base = cfg.slab ? cfg.slab->slot_offset(file_num) : 0;
+    if (cfg.rate_limiter) {
+        cfg.rate_limiter->wait_for_allowance(cfg.file_size, true);
+    }
+    auto close_file = [&](int fd) {
+        if (cfg.slab) {
+            cfg.slab->put_fd(fd);
+        } else if (cfg.fd_cache) {
+            cfg.fd_cache->release(file_num);
+        } else {
+            close(fd);
+        }
+    };
+    
+    Verifier::ReadCheck check;
+    if (cfg.verifier) check = cfg.verifier->begin_read(file_num);
+    
+    // 1. Open file (page cache access, so no O_DIRECT)
+    auto start_open = Clock::now();
+    int fd = cfg.slab ? cfg.slab->get_fd()
+           : cfg.fd_cache ? cfg.fd_cache->acquire(file_num) : cfg.paths ? cfg.paths->open(file_num, O_RDONLY) : open(filename().c_str(), O_RDONLY);
+    if (fd == -1) {
+        std::cerr << "Error opening file: " << filename() << " (errno: " << errno << ")" << std::endl;
+        return -1;
+    }
+    
+    // 2. Map it
+    auto start_map = Clock::now();
+    size_t length = (size_t)cfg.file_size;
+    char* data = nullptr;
+    if (length > 0) {
+        void* mapped = mmap(nullptr, length, PROT_READ, MAP_SHARED | (cfg.map_populate ? MAP_POPULATE : 0),
+                            fd, base);
+        if (mapped == MAP_FAILED) {
+            std::cerr << "Error mapping file " << filename() << " (errno: " << errno << ")" << std::endl;
+            close_file(fd);
+            return -1;
+        }
+        data = static_cast<char*>(mapped);
+        if (cfg.madvise_advice >= 0 && madvise(data, length, cfg.madvise_advice) != 0) {
+            std::cerr << "Error in madvise of " << filename() << " (errno: " << errno << ")" << std::endl;
+            munmap(data, length);
+            close_file(fd);
+            return -1;
+        }
+        if (cfg.huge_pages && madvise(data, length, MADV_HUGEPAGE) != 0) {
+            // Only filesystems with large folio / file THP support accept this
+            static std::atomic<bool> warned(false);
+            if (!warned.exchange(true)) {
+                std::cout << "Warning: MADV_HUGEPAGE not supported here (errno: " << errno 
+                          << "), using base pages" << std::endl;
+            }
+        }
+    }
+    
+    // 3. Consume the data in place
+    auto start_read = Clock::now();
+    uint64_t sum = 0;
+    if (!cfg.skip_read && data) {
+        if (cfg.verifier) {
+            // Checking every block reads every byte (--verify implies touch all)
+            cfg.verifier->check(data, length, 0, file_num, check);
+            cfg.verifier->finish(check);
+        } else if (cfg.touch_all) {
+            const uint64_t* words = reinterpret_cast<const uint64_t*>(data);
+            for (size_t i = 0; i < length / sizeof(uint64_t); i++) sum += words[i];
+        } else {
+            for (size_t offset = 0; offset < length; offset += 4096) sum += (unsigned char)data[offset];
+        }
+    }
+    mmap_sink = sum;
+    
+    // 4. Unmap and close
+    auto start_close = Clock::now();
+    if (data) munmap(data, length);
+    close_file(fd);
+    auto end_close = Clock::now();
+    
+    hist.open.record(elapsed_ns(start_open, start_map));
+    hist.map.record(elapsed_ns(start_map, start_read));
+    hist.read.record(elapsed_ns(start_read, start_close));
+    hist.close.record(elapsed_ns(start_close, end_close));
+    hist.file.record(elapsed_ns(start_open, end_close));
+    if (cfg.sampler) cfg.sampler->record(elapsed_ns(start_open, end_close), cfg.skip_read ? 0 : length);
+    return cfg.skip_read ? 0 : (long long)length;
+}
+
+// Minor and major page faults of the process so far
+static std::pair<long long, long long> page_faults() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return {0, 0};
+    return {usage.ru_minflt, usage.ru_majflt};
+}
+
+static void print_page_faults(std::pair<long long, long long> before, long long files) {
+    auto after = page_faults();
+    long long minor = after.first - before.first;
+    long long major = after.second - before.second;
+    std::cout << "Page faults: " << minor << " minor, " << major << " major (" 
+              << (double)(minor + major) / (files > 0 ? files : 1) << " per file)" << std::endl;
+}
+
+// One measured iteration of the sync engine: read or write file `file_num`
+static long long sync_file_op(const LoopConfig& cfg, int file_num, long long iteration,
+                              char* read_buffer, ReaderPool& reader_pool, PhaseHistograms& hist) {
+    if (cfg.write_workload) {
+        return sync_write_file(cfg, file_num, iteration, read_buffer, hist);
+    }
+    if (cfg.mmap_read) {
+        return mmap_read_file(cfg, file_num, hist);
+    }
+    return sync_read_file(cfg, file_num, read_buffer, reader_pool, hist);
+}
+
+// Parses --rwf, a comma-separated list of nowait and hipri, into RWF_* flags.
+// Returns false on an unknown name.
+static bool parse_rwf_flags(const std::string& list, int& flags) {
+    flags = 0;
+    size_t start = 0;
+    while (start < list.size()) {
+        size_t comma = list.find(',', start);
+        if (comma == std::string::npos) comma = list.size();
+        std::string flag = list.substr(start, comma - start);
+        start = comma + 1;
+        if (flag == "nowait") {
+            flags |= RWF_NOWAIT;
+        } else if (flag == "hipri") {
+            flags |= RWF_HIPRI;
+        } else {
+            std::cerr << "Unknown --rwf flag: " << flag << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Sync engine reading small files `group` at a time (--small_batch): the fds
+// of the whole group come from the fd cache (or the slab pool), then one
+// preadv2() per file with `rwf_flags` reads each file whole into its own
+// buffer. With RWF_NOWAIT a read that would block is counted and retried
+// without it. Phase latencies are per group, recorded once per file of the
+// group as the group time divided by its size. Returns false on error.
+static bool small_batch_read_loop(const LoopConfig& cfg, const std::vector<int>& file_permutation,
+                                  int ITER, int group, int rwf_flags, Clock::time_point start_read,
+                                  long long& total_bytes_read, PhaseHistograms& hist) {
+    ArenaLease buffers(*cfg.arena);
+    if (!buffers.take(group)) {
+        return false;
+    }
+    std::vector<int> files(group);
+    std::vector<int> fds(group);
+    long long nowait_retries = 0;
+    long long reads = 0;
+    long long completed = 0;
+    // Hands back the first `count` fds of the group
+    auto release_fds = [&](int count) {
+        for (int j = 0; j < count; j++) {
+            if (cfg.slab) {
+                cfg.slab->put_fd(fds[j]);
+            } else {
+                cfg.fd_cache->release(files[j]);
+            }
+        }
+    };
+    for (int i = 0; i < ITER && !out_of_time(cfg); i += group) {
+        int n = std::min(group, ITER - i);
+        if (cfg.rate_limiter) {
+            cfg.rate_limiter->wait_for_allowance(cfg.file_size * n, true);
+        }
+        auto start_open = Clock::now();
+        for (int j = 0; j < n; j++) {
+            files[j] = loop_file(cfg, file_permutation, i + j);
+            fds[j] = cfg.slab ? cfg.slab->get_fd() : cfg.fd_cache->acquire(files[j]);
+            if (fds[j] == -1) {
+                release_fds(j);
+                return false;
+            }
+        }
+        auto start_group_read = Clock::now();
+        long long group_bytes = 0;
+        for (int j = 0; j < n; j++) {
+            struct iovec iov = {buffers[j], (size_t)cfg.file_size};
+            off_t offset = cfg.slab ? cfg.slab->slot_offset(files[j]) : 0;
+            Verifier::ReadCheck check;
+            if (cfg.verifier) check = cfg.verifier->begin_read(files[j]);
+            ssize_t bytes_read = preadv2(fds[j], &iov, 1, offset, rwf_flags);
+            if (bytes_read < 0 && errno == EAGAIN && (rwf_flags & RWF_NOWAIT)) {
+                nowait_retries++;
+                bytes_read = preadv2(fds[j], &iov, 1, offset, rwf_flags & ~RWF_NOWAIT);
+            }
+            if (bytes_read != (ssize_t)cfg.file_size) {
+                std::cerr << "Error reading file " << (cfg.slab ? cfg.slab->name() : cfg.files.path(files[j]))
+                          << " with preadv2 (";
+                if (bytes_read < 0) {
+                    std::cerr << "errno: " << errno;
+                } else {
+                    std::cerr << "short read: " << bytes_read << " of " << cfg.file_size << " bytes";
+                }
+                std::cerr << ")" << std::endl;
+                release_fds(n);
+                return false;
+            }
+            if (cfg.verifier) {
+                cfg.verifier->check(buffers[j], (size_t)bytes_read, 0, files[j], check);
+                cfg.verifier->finish(check);
+            }
+            group_bytes += bytes_read;
+            reads++;
+        }
+        auto start_close = Clock::now();
+        release_fds(n);
+        auto end_close = Clock::now();
+        
+        for (int j = 0; j < n; j++) {
+            hist.open.record(elapsed_ns(start_open, start_group_read) / n);
+            hist.read.record(elapsed_ns(start_group_read, start_close) / n);
+            hist.close.record(elapsed_ns(start_close, end_close) / n);
+            hist.file.record(elapsed_ns(start_open, end_close) / n);
+            if (cfg.sampler) cfg.sampler->record(elapsed_ns(start_open, end_close) / n, group_bytes / n);
+        }
+        total_bytes_read += group_bytes;
+        
+        // Print progress every 1000 iterations
+        long long before = completed;
+        completed += n;
+        if (completed / 1000 != before / 1000) {
+            print_progress(completed, start_read);
+        }
+    }
+    if (rwf_flags & RWF_NOWAIT) {
+        std::cout << "RWF_NOWAIT: " << nowait_retries << " of " << reads << " reads would block and were retried" 
+                  << std::endl;
+    }
+    return true;
+}
+
+// Sync engine with `inflight` files outstanding: one thread per in-flight file,
+// each claiming the next iteration from a shared counter. Returns false on error.
+static bool sync_inflight_loop(const LoopConfig& cfg, const std::vector<int>& file_permutation,
+                               int ITER, int inflight, ReaderPool& reader_pool,
+                               Clock::time_point start_read, long long& total_bytes_read,
+                               PhaseHistograms& hist) {
+    
+    ArenaLease buffers(*cfg.arena);
+    if (!buffers.take(inflight)) {
+        return false;
+    }
+    
+    std::atomic<int> next_iter(0);
+    std::atomic<long long> completed(0);
+    std::atomic<bool> error_occurred(false);
+    std::vector<long long> thread_bytes(inflight, 0);
+    std::vector<PhaseHistograms> thread_hist(inflight);
+    std::mutex progress_mutex;
+    
+    std::vector<std::thread> threads;
+    for (int t = 0; t < inflight; t++) {
+        threads.emplace_back([&, t]() {
+            int i;
+            while (!error_occurred && !out_of_time(cfg) && (i = next_iter++) < ITER) {
+                long long bytes = sync_file_op(cfg, loop_file(cfg, file_permutation, i), i, buffers[t],
+                                               reader_pool, thread_hist[t]);
+                if (bytes < 0) {
+                    error_occurred = true;
+                    return;
+                }
+                thread_bytes[t] += bytes;
+                
+                long long done = ++completed;
+                if (done % 1000 == 0) {
+                    std::lock_guard<std::mutex> lock(progress_mutex);
+                    print_progress(done, start_read);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    for (int t = 0; t < inflight; t++) {
+        total_bytes_read += thread_bytes[t];
+        hist.merge(thread_hist[t]);
+    }
+    return !error_occurred;
+}
+
+// Mixed workload: `readers` threads read and `writers` threads write at the
+// same time, each drawing files from `selector`. Readers perform ITER reads in
+// total and writers keep writing until they are done (with no readers, the
+// writers perform ITER writes). With a read:write ratio the writers are paced
+// to ratio_writes writes per ratio_reads completed reads; without one they
+// apply unpaced background pressure. Returns false on error.
+struct MixedResult {
+    long long reads = 0;
+    long long writes = 0;
+    long long bytes_read = 0;
+    long long bytes_written = 0;
+    PhaseHistograms read_hist;
+    PhaseHistograms write_hist;
+};
+
+static bool mixed_loop(const LoopConfig& cfg, const FileSelector& selector, int ITER,
+                       int readers, int writers, int ratio_reads, int ratio_writes,
+                       ReaderPool& reader_pool, Clock::time_point start_read, MixedResult& result) {
+    ArenaLease buffers(*cfg.arena);
+    if (!buffers.take(readers + writers)) {
+        return false;
+    }
+    for (int t = readers; t < readers + writers; t++) fill_stamp_buffer(cfg, buffers[t]);
+    
+    std::atomic<int> next_read(0);
+    std::atomic<long long> reads_done(0);
+    std::atomic<long long> next_write(0);
+    std::atomic<long long> writes_done(0);
+    std::atomic<bool> readers_finished(readers == 0);
+    std::atomic<bool> error_occurred(false);
+    std::vector<long long> thread_bytes(readers + writers, 0);
+    std::vector<PhaseHistograms> thread_hist(readers + writers);
+    std::mutex progress_mutex;
+    // Writers of the same entry take turns, so its last write to start is
+    // the last to land (--verify commits the newest generation)
+    const int STRIPES = 1024;
+    std::unique_ptr<std::mutex[]> stripes(new std::mutex[STRIPES]);
+    
+    std::vector<std::thread> threads;
+    for (int t = 0; t < readers; t++) {
+        threads.emplace_back([&, t]() {
+            std::mt19937_64 rng(std::random_device{}());
+            while (!error_occurred && !out_of_time(cfg) && next_read++ < ITER) {
+                int file_num = selector.next(rng);
+                long long bytes = cfg.mmap_read
+                    ? mmap_read_file(cfg, file_num, thread_hist[t])
+                    : sync_read_file(cfg, file_num, buffers[t], reader_pool, thread_hist[t]);
+                if (bytes < 0) {
+                    error_occurred = true;
+                    return;
+                }
+                thread_bytes[t] += bytes;
+                long long done = ++reads_done;
+                if (done % 1000 == 0) {
+                    std::lock_guard<std::mutex> lock(progress_mutex);
+                    print_progress(done, start_read);
+                }
+            }
+        });
+    }
+    for (int t = readers; t < readers + writers; t++) {
+        threads.emplace_back([&, t]() {
+            std::mt19937_64 rng(std::random_device{}());
+            while (!error_occurred) {
+                if (readers == 0) {
+                    if (next_write.load() >= ITER || out_of_time(cfg)) return;
+                } else if (readers_finished) {
+                    return;
+                }
+                if (ratio_reads > 0) {
+                    // Stay within the configured share of the reads completed so far
+                    long long allowed = reads_done.load() * ratio_writes / ratio_reads;
+                    if (writes_done.load() >= allowed && readers > 0) {
+                        std::this_thread::sleep_for(std::chrono::microseconds(20));
+                        continue;
+                    }
+                }
+                long long w = next_write++;
+                if (readers == 0 && w >= ITER) return;
+                int file_num = selector.next(rng);
+                std::lock_guard<std::mutex> lock(stripes[file_num % STRIPES]);
+                long long bytes = sync_write_file(cfg, file_num, w, buffers[t], thread_hist[t]);
+                if (bytes < 0) {
+                    error_occurred = true;
+                    return;
+                }
+                thread_bytes[t] += bytes;
+                writes_done++;
+            }
+        });
+    }
+    for (int t = 0; t < readers; t++) {
+        threads[t].join();
+    }
+    readers_finished = true;
+    for (int t = readers; t < readers + writers; t++) {
+        threads[t].join();
+    }
+    
+    for (int t = 0; t < readers + writers; t++) {
+        if (t < readers) {
+            result.bytes_read += thread_bytes[t];
+            result.read_hist.merge(thread_hist[t]);
+        } else {
+            result.bytes_written += thread_bytes[t];
+            result.write_hist.merge(thread_hist[t]);
+        }
+    }
+    result.reads = reads_done;
+    result.writes = writes_done;
+    return !error_occurred;
+}
+
+// Trace replay: `workers` threads issue the operations of `trace` open loop,
+// each at its recorded time divided by `speed` (0 = back to back). An
+// operation that finds every worker busy starts late and the wait counts
+// toward its latency: the scheduled phase runs from the intended start to
+// completion, so a stall shows up in the tail instead of quietly lowering the
+// offered load (coordinated omission). Reads and writes cover the recorded
+// size rounded up to whole 4 KB blocks (for O_DIRECT) and capped at the file
+// size; a write after a delete recreates the file, and a read of a deleted
+// file (or of one in `missing`, absent before the replay) is counted as a
+// miss. Operations that remove or recreate a file hold
+// its lock stripe exclusively, so a read never trips over a half-done delete.
+// Returns false on error.
+struct ReplayResult {
+    long long ops[3] = {0, 0, 0};   // By TraceOp
+    long long bytes_read = 0;
+    long long bytes_written = 0;
+    long long misses = 0;           // Reads of files the trace had deleted
+    long long late = 0;             // Operations started more than 1 ms after their intended time
+    uint64_t max_lag_ns = 0;
+    uint64_t trace_ns = 0;          // Recorded time of the last replayed operation
+    PhaseHistograms hist[3];        // By TraceOp
+};
+
+static bool replay_loop(const LoopConfig& cfg, TraceReader& trace, const std::vector<char>& missing,
+                        int workers, double speed, ReaderPool& reader_pool, Clock::time_point start_read,
+                        ReplayResult& result) {
+    const int num_files = (int)missing.size() - 1;
+    ArenaLease buffers(*cfg.arena);
+    if (!buffers.take(workers)) {
+        return false;
+    }
+    for (int t = 0; t < workers; t++) fill_stamp_buffer(cfg, buffers[t]);
+    const uint64_t LATE_NS = 1000000;
+    std::unique_ptr<std::atomic<bool>[]> deleted(new std::atomic<bool>[num_files + 1]);
+    for (int i = 0; i <= num_files; i++) deleted[i].store(missing[i] != 0, std::memory_order_relaxed);
+    const int STRIPES = 1024;
+    std::unique_ptr<std::shared_mutex[]> stripes(new std::shared_mutex[STRIPES]);
+    
+    std::atomic<long long> completed(0);
+    std::atomic<bool> error_occurred(false);
+    std::vector<ReplayResult> thread_result(workers);
+    std::mutex progress_mutex;
+    
+    auto round_size = [&](uint32_t size, bool direct) {
+        long long bytes = size == 0 ? cfg.file_size : (long long)size;
+        if (direct) bytes = (bytes + 4095) / 4096 * 4096;
+        return std::min(bytes, cfg.file_size);
+    };
+    
+    std::vector<std::thread> threads;
+    for (int t = 0; t < workers; t++) {
+        threads.emplace_back([&, t]() {
+            ReplayResult& mine = thread_result[t];
+            // Per-thread copy whose size and write variant follow each record
+            LoopConfig op_cfg = cfg;
+            long long write_index = 0;
+            TraceRecord record;
+            while (!error_occurred && !out_of_time(cfg) && trace.next(record)) {
+                Clock::time_point intended = Clock::now();
+                if (speed > 0) {
+                    intended = start_read + std::chrono::nanoseconds((uint64_t)(record.time_ns / speed));
+                    std::this_thread::sleep_until(intended);
+                }
+                uint64_t lag = elapsed_ns(intended, Clock::now());
+                if (lag > LATE_NS) mine.late++;
+                mine.max_lag_ns = std::max(mine.max_lag_ns, lag);
+                mine.trace_ns = std::max(mine.trace_ns, record.time_ns);
+                
+                int file_num = (int)record.file_num;
+                PhaseHistograms& hist = mine.hist[record.op];
+                std::shared_mutex& stripe = stripes[file_num % STRIPES];
+                if (record.op == TRACE_READ) {
+                    std::shared_lock<std::shared_mutex> lock(stripe);
+                    if (deleted[file_num]) {
+                        mine.misses++;
+                        continue;
+                    }
+                    op_cfg.file_size = round_size(record.size, true);
+                    long long bytes = sync_read_file(op_cfg, file_num, buffers[t], reader_pool, hist);
+                    if (bytes < 0) {
+                        error_occurred = true;
+                        return;
+                    }
+                    mine.bytes_read += bytes;
+                } else if (record.op == TRACE_WRITE) {
+                    // Writes in place share the stripe with reads; recreating the file does not
+                    std::shared_lock<std::shared_mutex> shared(stripe, std::defer_lock);
+                    std::unique_lock<std::shared_mutex> exclusive(stripe, std::defer_lock);
+                    if (cfg.write_variant == "create") {
+                        exclusive.lock();
+                    } else {
+                        shared.lock();
+                        if (deleted[file_num]) {
+                            shared.unlock();
+                            exclusive.lock();
+                        }
+                    }
+                    op_cfg.file_size = round_size(record.size, cfg.write_direct);
+                    op_cfg.write_variant = deleted[file_num] ? "create" : cfg.write_variant;
+                    long long bytes = sync_write_file(op_cfg, file_num, write_index++, buffers[t], hist);
+                    if (bytes < 0) {
+                        error_occurred = true;
+                        return;
+                    }
+                    deleted[file_num] = false;
+                    mine.bytes_written += bytes;
+                } else {
+                    std::string filename = cfg.files.path(file_num);
+                    std::unique_lock<std::shared_mutex> lock(stripe);
+                    auto start_delete = Clock::now();
+                    if (unlink(filename.c_str()) != 0 && errno != ENOENT) {
+                        std::cerr << "Error deleting file " << filename << " (errno: " << errno << ")" << std::endl;
+                        error_occurred = true;
+                        return;
+                    }
+                    deleted[file_num] = true;
+                    hist.file.record(elapsed_ns(start_delete, Clock::now()));
+                }
+                hist.scheduled.record(elapsed_ns(intended, Clock::now()));
+                mine.ops[record.op]++;
+                long long done = ++completed;
+                if (done % 1000 == 0) {
+                    std::lock_guard<std::mutex> lock(progress_mutex);
+                    print_progress(done, start_read);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    trace.stop();
+    
+    for (const ReplayResult& mine : thread_result) {
+        for (int op = 0; op < 3; op++) {
+            result.ops[op] += mine.ops[op];
+            result.hist[op].merge(mine.hist[op]);
+        }
+        result.bytes_read += mine.bytes_read;
+        result.bytes_written += mine.bytes_written;
+        result.misses += mine.misses;
+        result.late += mine.late;
+        result.max_lag_ns = std::max(result.max_lag_ns, mine.max_lag_ns);
+        result.trace_ns = std::max(result.trace_ns, mine.trace_ns);
+    }
+    if (trace.failed()) {
+        return false;
+    }
+    return !error_occurred;
+}
+
+// Read loop for --engine=io_uring. Keeps `window` files open in fixed file
+// slots and queues their chunks as READ_FIXED SQEs against registered buffers,
+// with up to queue_depth reads in flight. With `rolling` a slot is refilled with
+// the next file as soon as its file completes (--inflight); otherwise all slots
+// are refilled together once the whole batch is done (--batch_files), so the
+// chunks of a batch go out as one submission. Returns false on error.
+static bool io_uring_read_loop(const LoopConfig& cfg, const std::vector<int>& file_permutation,
+                               int ITER, int window, bool rolling, Clock::time_point start_read,
+                               long long& total_bytes_read, PhaseHistograms& hist) {
+    const int QUEUE_DEPTH = cfg.queue_depth;
+    
+    IoUring ring;
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = cfg.uring_setup;
+    if (cfg.uring_setup & IORING_SETUP_SQPOLL) {
+        params.sq_thread_idle = cfg.sqpoll_idle_ms;
+        if (cfg.sqpoll_cpu >= 0) {
+            params.flags |= IORING_SETUP_SQ_AFF;
+            params.sq_thread_cpu = (unsigned)cfg.sqpoll_cpu;
+        }
+    }
+    int ret = ring.init(QUEUE_DEPTH, params);
+    if (ret < 0 && cfg.uring_setup != 0) {
+        std::cout << "Warning: io_uring polling setup failed (errno: " << -ret 
+                  << "), using interrupt-driven completions" << std::endl;
+        ret = ring.init(QUEUE_DEPTH, 0);
+    }
+    if (ret < 0) {
+        std::cerr << "Error setting up io_uring (errno: " << -ret << ")" << std::endl;
+        return false;
+    }
+    
+    // One arena buffer per in-flight read, registered once for all iterations
+    ArenaLease buffers(*cfg.arena);
+    if (!buffers.take(QUEUE_DEPTH)) {
+        return false;
+    }
+    std::vector<struct iovec> iovs(QUEUE_DEPTH);
+    for (int b = 0; b < QUEUE_DEPTH; b++) {
+        iovs[b].iov_base = buffers[b];
+        iovs[b].iov_len = cfg.chunk_size;
+    }
+    ret = ring.register_buffers(iovs);
+    bool fixed_buffers = (ret == 0);
+    if (!fixed_buffers) {
+        std::cout << "Warning: io_uring buffer registration failed (errno: " << -ret 
+                  << "), using unregistered buffers" << std::endl;
+    }
+    // Sparse fixed file table, one slot per file in the window
+    ret = ring.register_files(std::vector<int>(window, -1));
+    bool fixed_files = (ret == 0);
+    if (!fixed_files) {
+        std::cout << "Warning: io_uring file registration failed (errno: " << -ret 
+                  << "), using plain fds" << std::endl;
+    }
+    
+    struct Slot {
+        int fd = -1;
+        int file_num = 0;
+        off_t base = 0;             // Slot offset in the slab layout
+        long long next_offset = 0;  // Next chunk to queue
+        int outstanding = 0;        // Chunks queued but not completed
+        Clock::time_point start;  // Before open
+        Clock::time_point opened;
+        Verifier::ReadCheck check;  // --verify
+    };
+    std::vector<Slot> slots(window);
+    std::vector<long long> buffer_offset(QUEUE_DEPTH);  // File offset each buffer's read started at
+    std::vector<unsigned> buffer_len(QUEUE_DEPTH);      // and the bytes it asked for
+    std::vector<unsigned> idle_buffers;
+    for (int b = QUEUE_DEPTH - 1; b >= 0; b--) idle_buffers.push_back(b);
+    int next_iter = 0;
+    int active = 0;
+    int inflight = 0;
+    long long completed = 0;
+    bool read_error = false;
+    
+    auto close_slot = [&](Slot& slot) {
+        if (cfg.slab) {
+            cfg.slab->put_fd(slot.fd);
+        } else if (cfg.fd_cache) {
+            cfg.fd_cache->release(slot.file_num);
+        } else {
+            close(slot.fd);
+        }
+        slot.fd = -1;
+    };
+    auto close_all = [&]() {
+        for (auto& slot : slots) {
+            if (slot.fd != -1) close_slot(slot);
+        }
+    };
+    
+    int last_iter = ITER;
+    while (!read_error && (next_iter < last_iter || active > 0)) {
+        // Past a --duration deadline only the files already open are finished
+        if (last_iter > next_iter && out_of_time(cfg)) last_iter = next_iter;
+        // 1. Open files into free slots with O_DIRECT
+        if (rolling || active == 0) {
+            for (int s = 0; s < window && next_iter < last_iter; s++) {
+                Slot& slot = slots[s];
+                if (slot.fd != -1) continue;
+                slot.file_num = loop_file(cfg, file_permutation, next_iter);
+                auto filename = [&] { return cfg.slab ? cfg.slab->name() : cfg.files.path(slot.file_num); };
+                slot.base = cfg.slab ? cfg.slab->slot_offset(slot.file_num) : 0;
+                if (cfg.rate_limiter) {
+                    cfg.rate_limiter->wait_for_allowance(cfg.file_size, true);
+                }
+                if (cfg.verifier) slot.check = cfg.verifier->begin_read(slot.file_num);
+                slot.start = Clock::now();
+                slot.fd = cfg.slab ? cfg.slab->get_fd()
+                        : cfg.fd_cache ? cfg.fd_cache->acquire(slot.file_num)
+                        : cfg.paths ? open_for_read(*cfg.paths, slot.file_num) : open_for_read(filename());
+                if (slot.fd == -1) {
+                    read_error = true;
+                    break;
+                }
+                slot.opened = Clock::now();
+                if (fixed_files && ring.update_file(s, slot.fd) != 0) {
+                    std::cerr << "Error updating io_uring file slot for " << filename() << std::endl;
+                    read_error = true;
+                    break;
+                }
+                slot.next_offset = cfg.skip_read ? cfg.file_size : 0;
+                slot.outstanding = 0;
+                next_iter++;
+                active++;
+            }
+            if (read_error) break;
+        }
+        
+        // 2. Queue as many chunks of the open files as there are idle buffers
+        for (int s = 0; s < window && !idle_buffers.empty(); s++) {
+            Slot& slot = slots[s];
+            while (slot.fd != -1 && slot.next_offset < cfg.file_size && !idle_buffers.empty()) {
+                unsigned len = (unsigned)std::min<long long>(cfg.chunk_size, cfg.file_size - slot.next_offset);
+                unsigned buf = idle_buffers.back();
+                idle_buffers.pop_back();
+                struct io_uring_sqe* sqe = ring.get_sqe();
+                IoUring::prep_rw(sqe, fixed_buffers ? IORING_OP_READ_FIXED : IORING_OP_READ,
+                                 fixed_files ? s : slot.fd, iovs[buf].iov_base, len, slot.base + slot.next_offset);
+                if (fixed_buffers) sqe->buf_index = (unsigned short)buf;
+                if (fixed_files) sqe->flags |= IOSQE_FIXED_FILE;
+                sqe->user_data = ((unsigned long long)s << 32) | buf;
+                buffer_offset[buf] = slot.next_offset;
+                buffer_len[buf] = len;
+                slot.next_offset += len;
+                slot.outstanding++;
+                inflight++;
+            }
+        }
+        
+        // 3. Submit, wait for at least one completion and drain the CQ
+        if (inflight > 0) {
+            int r = ring.submit(1);
+            if (r < 0 && r != -EINTR) {
+                std::cerr << "Error submitting to io_uring (errno: " << -r << ")" << std::endl;
+                read_error = true;
+                break;
+            }
+            struct io_uring_cqe* cqe;
+            while ((cqe = ring.peek_cqe()) != nullptr) {
+                Slot& done = slots[cqe->user_data >> 32];
+                unsigned buf = (unsigned)(cqe->user_data & 0xffffffffu);
+                if (cqe->res >= 0 && (unsigned)cqe->res != buffer_len[buf]) {
+                    std::cerr << "Error in io_uring read of file "
+                              << (cfg.slab ? cfg.slab->name() : cfg.files.path(done.file_num)) << " (short read: "
+                              << cqe->res << " of " << buffer_len[buf] << " bytes at offset " << buffer_offset[buf]
+                              << ")" << std::endl;
+                    read_error = true;
+                } else if (cqe->res < 0) {
+                    std::cerr << "Error in io_uring read (errno: " << -cqe->res << ")" << std::endl;
+                    if (cqe->res == -EOPNOTSUPP && (ring.flags() & IORING_SETUP_IOPOLL)) {
+                        std::cerr << "IOPOLL needs O_DIRECT reads on a device with poll queues "
+                                  << "(e.g. nvme poll_queues > 0)" << std::endl;
+                    }
+                    read_error = true;
+                } else {
+                    total_bytes_read += cqe->res;
+                }
+                if (cfg.verifier && cqe->res > 0) {
+                    cfg.verifier->check(static_cast<const char*>(iovs[buf].iov_base), (size_t)cqe->res,
+                                        buffer_offset[buf], done.file_num, done.check);
+                }
+                done.outstanding--;
+                idle_buffers.push_back(buf);
+                inflight--;
+                ring.cqe_seen();
+            }
+        }
+        
+        // 4. Close every file whose chunks have all completed
+        for (auto& slot : slots) {
+            if (slot.fd == -1 || slot.next_offset < cfg.file_size || slot.outstanding > 0) continue;
+            if (cfg.verifier && !cfg.skip_read) cfg.verifier->finish(slot.check);
+            auto start_close = Clock::now();
+            close_slot(slot);
+            auto end_close = Clock::now();
+            hist.open.record(elapsed_ns(slot.start, slot.opened));
+            hist.read.record(elapsed_ns(slot.opened, start_close));
+            hist.close.record(elapsed_ns(start_close, end_close));
+            hist.file.record(elapsed_ns(slot.start, end_close));
+            if (cfg.sampler) {
+                cfg.sampler->record(elapsed_ns(slot.start, end_close), cfg.skip_read ? 0 : cfg.file_size);
+            }
+            active--;
+            // Print progress every 1000 iterations
+            if (++completed % 1000 == 0) {
+                print_progress(completed, start_read);
+            }
+        }
+    }
+    
+    if (read_error) {
+        // Let in-flight reads land before their buffers go back to the arena
+        while (inflight > 0) {
+            struct io_uring_cqe* cqe;
+            if (ring.wait_cqe(&cqe) < 0) break;
+            inflight--;
+            ring.cqe_seen();
+        }
+        close_all();
+        return false;
+    }
+    if (ring.flags() & IORING_SETUP_SQPOLL) {
+        std::cout << "SQPOLL: " << ring.sq_wakeups() << " wakeups of the idle SQ thread" << std::endl;
+    }
+    return true;
+}
+
+// Per-thread outcome of sharded_loop
+struct ShardResult {
+    std::vector<int> cpus;  // Pinned CPU set (empty = not pinned)
+    long long files = 0;
+    long long bytes = 0;
+    double seconds = 0;
+    PhaseHistograms hist;
+};
+
+// --threads: `threads` threads each own the files file_permutation[j] with
+// j % threads == t and work through their share of the ITER iterations on
+// that shard alone, with their own buffer and stats and no shared iteration
+// counter. Thread t is pinned to cpu_sets[t % size] if any are given. On
+// io_uring every thread drives its own ring. Returns false on error.
+static bool sharded_loop(const LoopConfig& cfg, const std::vector<int>& file_permutation,
+                         int ITER, int threads, const std::vector<std::vector<int>>& cpu_sets,
+                         bool io_uring, int window, ReaderPool& reader_pool,
+                         Clock::time_point start_read, std::vector<ShardResult>& results) {
+    std::vector<std::vector<int>> shards(threads);
+    for (size_t j = 0; j < file_permutation.size(); j++) {
+        shards[j % threads].push_back(file_permutation[j]);
+    }
+    results.assign(threads, ShardResult());
+    
+    std::atomic<long long> completed(0);
+    std::atomic<bool> error_occurred(false);
+    std::mutex progress_mutex;
+    
+    auto worker = [&](int t) {
+        ShardResult& result = results[t];
+        if (!cpu_sets.empty()) {
+            result.cpus = cpu_sets[t % cpu_sets.size()];
+            if (!pin_current_thread(result.cpus)) {
+                error_occurred = true;
+                return;
+            }
+        }
+        int iterations = ITER / threads + (t < ITER % threads ? 1 : 0);
+        const std::vector<int>& shard = shards[t];
+        auto start_thread = Clock::now();
+        
+        if (io_uring) {
+            if (!io_uring_read_loop(cfg, shard, iterations, window, false, start_read,
+                                    result.bytes, result.hist)) {
+                error_occurred = true;
+                return;
+            }
+            result.files = (long long)result.hist.file.count();
+        } else {
+            ArenaLease buffer(*cfg.arena);
+            if (!buffer.take(1)) {
+                error_occurred = true;
+                return;
+            }
+            fill_stamp_buffer(cfg, buffer[0]);
+            for (int i = 0; i < iterations && !error_occurred && !out_of_time(cfg); i++) {
+                long long bytes = sync_file_op(cfg, loop_file(cfg, shard, i), i, buffer[0],
+                                               reader_pool, result.hist);
+                if (bytes < 0) {
+                    error_occurred = true;
+                    return;
+                }
+                result.bytes += bytes;
+                result.files++;
+                
+                long long done = ++completed;
+                if (done % 1000 == 0) {
+                    std::lock_guard<std::mutex> lock(progress_mutex);
+                    print_progress(done, start_read);
+                }
+            }
+        }
+        result.seconds = elapsed_us(start_thread, Clock::now()) / 1e6;
+    };
+    
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back(worker, t);
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    return !error_occurred;
+}
+
+// Native version of System.run_benchmark in file_manager.py. Keeps up to
+// max_inflight_requests requests outstanding; a request is num_workers reads
+// run in parallel, and each completed request fires num_workers writes (with
+// eviction) at the writer threads without waiting for them. Before a request is
+// started the loop waits for a free place in the write queue. The totals and
+// the read, write and request (as "file") latencies go to `run`. Returns false on error.
+// `pipeline`, if set, takes the follow-up writes instead of the writer pool and
+// the write semaphore; requests then wait only while its queue is full
+static bool run_manager_benchmark(BaseFileManager& manager, const ManagerConfig& cfg,
+                                  int requests_to_complete, WritePipeline* pipeline, LatencyRun& run) {
+    const int num_workers = cfg.num_workers;
+    const int max_inflight = cfg.max_inflight_requests;
+    
+    TaskPool readers;
+    TaskPool writers;
+    readers.start(max_inflight * num_workers);
+    // The write semaphore admits max_write_waiters writes at a time; more threads would only block
+    if (pipeline) {
+        pipeline->start();
+    } else {
+        writers.start(cfg.max_write_waiters);
+    }
+    std::vector<LatencyHistogram> read_hist(readers.size());
+    std::vector<LatencyHistogram> write_hist(writers.size());
+    LatencyHistogram request_hist;
+    std::atomic<bool> error_occurred(false);
+    
+    struct RequestSlot {
+        std::atomic<int> remaining{0};
+        Clock::time_point start;
+    };
+    std::vector<RequestSlot> slots(max_inflight);
+    std::vector<int> free_slots;
+    for (int r = max_inflight - 1; r >= 0; r--) free_slots.push_back(r);
+    std::mutex done_mutex;
+    std::condition_variable done_cv;
+    std::vector<int> done_slots;
+    
+    auto start_time = Clock::now();
+    auto last_print_time = start_time;
+    long long last_print_count = 0;
+    long long completed_requests = 0;
+    int pending_requests = 0;
+    
+    while (completed_requests < requests_to_complete && !error_occurred) {
+        while (pending_requests < max_inflight && 
+               completed_requests + pending_requests < requests_to_complete) {
+            if (!pipeline) manager.sync_wait_for_place_in_write_queue();
+            int slot = free_slots.back();
+            free_slots.pop_back();
+            slots[slot].remaining = num_workers;
+            slots[slot].start = Clock::now();
+            for (int w = 0; w < num_workers; w++) {
+                readers.submit([&, slot, w](int t) {
+                    auto start_op = Clock::now();
+                    if (!manager.read_kv_single_file(w)) {
+                        error_occurred = true;
+                    }
+                    read_hist[t].record(elapsed_ns(start_op, Clock::now()));
+                    if (--slots[slot].remaining == 0) {
+                        std::lock_guard<std::mutex> lock(done_mutex);
+                        done_slots.push_back(slot);
+                        done_cv.notify_one();
+                    }
+                });
+            }
+            pending_requests++;
+        }
+        
+        std::vector<int> done;
+        {
+            std::unique_lock<std::mutex> lock(done_mutex);
+            done_cv.wait(lock, [&] { return !done_slots.empty(); });
+            done.swap(done_slots);
+        }
+        auto now = Clock::now();
+        for (int slot : done) {
+            request_hist.record(elapsed_ns(slots[slot].start, now));
+            free_slots.push_back(slot);
+            pending_requests--;
+            completed_requests++;
+            for (int w = 0; w < num_workers; w++) {
+                if (pipeline) {
+                    pipeline->submit(w, true);
+                    continue;
+                }
+                writers.submit([&, w](int t) {
+                    auto start_op = Clock::now();
+                    if (!manager.write_kv_single_file(w, true)) {
+                        error_occurred = true;
+                    }
+                    write_hist[t].record(elapsed_ns(start_op, Clock::now()));
+                });
+            }
+        }
+        
+        if (completed_requests - last_print_count >= 1000) {
+            double total_bw = completed_requests / (elapsed_us(start_time, now) / 1e6);
+            double recent_bw = (completed_requests - last_print_count) / (elapsed_us(last_print_time, now) / 1e6);
+            std::cout << "Completed " << completed_requests << " requests | Total BW: " << total_bw 
+                      << " req/s | Recent BW: " << recent_bw << " req/s" << std::endl;
+            last_print_time = now;
+            last_print_count = completed_requests;
+        }
+    }
+    
+    auto end_time = Clock::now();
+    int semaphore_value = manager.write_semaphore_value();
+    readers.stop();
+    writers.stop();
+    if (pipeline) pipeline->stop();
+    auto drained_time = Clock::now();
+    if (error_occurred || (pipeline && pipeline->failed())) {
+        std::cerr << "Error in file manager operation, benchmark aborted" << std::endl;
+        return false;
+    }
+    
+    LatencyHistogram reads, writes;
+    for (const auto& h : read_hist) reads.merge(h);
+    for (const auto& h : write_hist) writes.merge(h);
+    if (pipeline) writes.merge(pipeline->write_latency());
+    double total_time = elapsed_us(start_time, end_time) / 1e6;
+    
+    std::cout << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << "Benchmark completed!" << std::endl;
+    std::cout << "============================================================" << std::endl;
+    std::cout << "Total requests: " << completed_requests << std::endl;
+    std::cout << "Total time: " << total_time << " seconds" << std::endl;
+    std::cout << "Overall BW: " << (completed_requests / total_time) << " req/s" << std::endl;
+    if (pipeline) {
+        pipeline->print_stats();
+    } else {
+        std::cout << "Final semaphore value: " << semaphore_value << std::endl;
+    }
+    std::cout << "Pending writes drained in: " << elapsed_us(end_time, drained_time) / 1000.0 << " ms" << std::endl;
+    print_latency_rows("Latency per operation", {
+        {"read", &reads}, {"write", &writes}, {"request", &request_hist}});
+    
+    run.inflight = max_inflight;
+    run.label = "manager";
+    run.hist.read = reads;
+    run.hist.write = writes;
+    run.hist.file = request_hist;
+    run.seconds = total_time;
+    run.ops = completed_requests;
+    run.bytes = (long long)(reads.count() + writes.count()) * cfg.file_size;
+    return true;
+}
+
 int main(int argc, char* argv[]) {
     // Parameters
     int N = 10;           // Number of files
@@ -27,36 +1544,869 @@ int main(int argc, char* argv[]) {
     bool SKIP_WRITE = false;  // If true: create files but skip writing data (empty files)
     size_t CHUNK_SIZE = 4 * 1024 * 1024;  // Chunk size for reading (4 MB default)
     bool PARALLEL_READ = false;  // If true: issue parallel reads for all chunks
+    std::string ENGINE = "sync";  // Read engine: "sync" (read/pread), "io_uring" or "mmap"
+    std::string URING_POLL = "none";  // io_uring completions: none (interrupts), iopoll, sqpoll or iopoll,sqpoll
+    int SQPOLL_CPU = -1;  // io_uring SQPOLL: bind the kernel SQ thread to this CPU (-1 = any)
+    int SQPOLL_IDLE_MS = 1000;  // io_uring SQPOLL: idle time before the SQ thread sleeps
+    int QUEUE_DEPTH = 64;  // io_uring: max chunk reads in flight (ring size and registered buffers)
+    int BATCH_FILES = 1;  // io_uring: number of files whose chunks are submitted as one batch
+    int POOL_THREADS = 0;  // PARALLEL_READ: reader pool size (0 = one worker per chunk of a file)
+    int POOL_QUEUE = 0;  // PARALLEL_READ: max queued chunk reads (0 = twice the pool size)
+    std::string LATENCY_JSON;  // If set: write per-phase latency percentiles to this file as JSON
+    std::string OUTPUT;  // If set: write all parameters, environment and results as json or csv
+    std::string OUTPUT_FILE = "-";  // Where --output goes ("-" = stdout, after the run)
+    double DURATION = 0;  // If > 0: run each measured phase for DURATION seconds instead of ITER iterations
+    std::string WARMUP;  // Discarded pass before measuring: "<seconds>s" or an iteration count
+    int REPEAT = 1;  // Repeat the measured phase and report mean, stddev and 95% confidence intervals
+    bool IO_STATS = true;  // Report device (/sys/dev/block) and process (/proc/self/io) I/O per phase
+    int SAMPLE_MS = 0;  // If > 0: record files/s, MB/s and latency percentiles every SAMPLE_MS ms
+    std::string SAMPLE_FILE;  // Write the --sample_ms time series to this CSV file (default: print it)
+    std::string MANAGER;  // If set: run the native file_manager.py workload with this strategy instead
+    int MAX_INFLIGHT_REQUESTS = 4;  // Manager mode: requests outstanding at once
+    int MAX_WRITE_WAITERS = 4;  // Manager mode: concurrent writes allowed by the write semaphore
+    int WORKERS_PER_REQUEST = 1;  // Manager mode: reads per request (and writes per completed request)
+    bool MANAGER_O_DIRECT = false;  // Manager mode: open data files with O_DIRECT (Python uses buffered I/O)
+    bool LOCK_FREE_POOL = true;  // Manager mode: sharded random file checkout (false = one global files_lock)
+    bool POOL_SCALING = false;  // If set: compare the sharded and locked file pools over N ids, ITER pops per thread, and exit
+    std::string WRITE_PIPELINE = "off";  // Manager mode: off (semaphore + writer pool), pwrite or io_uring writer stage
+    int PIPELINE_WRITERS = 0;  // Write pipeline: writer threads (0 = MAX_WRITE_WAITERS)
+    int PIPELINE_QUEUE = 0;  // Write pipeline: queued writes before requests block (0 = one per request read)
+    int PIPELINE_BATCH = 8;  // Write pipeline: queued writes a writer submits together
+    int POPULATE_THREADS = (int)std::max(1u, std::thread::hardware_concurrency());  // Threads creating the file set
+    std::string FILL = "random";  // File contents: random (fast PRNG), zero or pattern
+    bool FALLOCATE = false;  // Preallocate each file with fallocate() before writing it
+    bool POPULATE_O_DIRECT = false;  // Write the file set with O_DIRECT
+    std::string WORKLOAD = "read";  // Measured loop: read, write, mixed, or replay a recorded trace
+    std::string WRITE_VARIANT = "overwrite";  // Write workload: create, overwrite or prealloc
+    bool WRITE_DIRECT = true;  // Write workload: O_DIRECT (false = buffered)
+    bool WRITE_DSYNC = false;  // Write workload: open with O_DSYNC
+    int FDATASYNC_EVERY = 0;  // Write workload: fdatasync() after every Nth write (0 = never)
+    int READERS = 1;  // Mixed workload: reader threads
+    int WRITERS = 1;  // Mixed workload: writer threads
+    std::string RW_RATIO;  // Mixed workload: "reads:writes" pacing of the writers (empty = unpaced)
+    std::string TRACE;  // Replay workload: JSONL or binary trace of read/write/delete operations (see trace_replay.h)
+    std::string TRACE_CONVERT;  // If set: write TRACE as a binary trace to this file and exit
+    double REPLAY_SPEED = 1;  // Replay workload: issue at this multiple of the recorded rate (0 = back to back)
+    int REPLAY_WORKERS = 16;  // Replay workload: threads issuing the operations
+    int RATIO_READS = 0;
+    int RATIO_WRITES = 0;
+    std::string DISTRIBUTION = "uniform";  // File selection: uniform, zipf or hotset
+    double ZIPF_THETA = 0.99;  // zipf: skew, in (0, 1)
+    double HOT_FRACTION = 0.1;  // hotset: fraction of the files that are hot
+    double HOT_ACCESS = 0.9;  // hotset: fraction of the accesses that go to hot files
+    double RATE_LIMIT = 0;  // Bytes/s shared by reads and writes (0 = unlimited)
+    double READ_RATE_LIMIT = 0;  // Bytes/s for reads only (0 = unlimited or RATE_LIMIT)
+    double WRITE_RATE_LIMIT = 0;  // Bytes/s for writes only (0 = unlimited or RATE_LIMIT)
+    long long RATE_GRANULARITY_US = 1000;  // Token bucket refill interval
+    std::string FD_CACHE = "0";  // Keep-open fds for reads: 0 (open/close per read), a capacity, or "all"
+    bool MAP_POPULATE_FLAG = false;  // mmap engine: prefault with MAP_POPULATE
+    std::string MADVISE = "none";  // mmap engine: none, sequential, random or willneed
+    bool HUGE_PAGES = false;  // mmap engine: MADV_HUGEPAGE where the filesystem supports it
+    std::string MMAP_TOUCH = "page";  // mmap engine: touch one byte per page, or "all" words
+    int THREADS = 1;  // Threads sharing the ITER loop, each on its own shard of the files
+    std::string PIN_CPUS;  // Pin thread t to CPU t of this cpulist (e.g. "0-7"), round robin
+    std::string PIN_NODES;  // Pin thread t to the CPUs of NUMA node t of this list, round robin; "device" = node of PATH's device
+    bool ARENA_HUGE_PAGES = false;  // Back the buffer arena with huge pages
+    bool ARENA_MLOCK = false;  // mlock() the buffer arena
+    std::string LAYOUT = "files";  // files (f1..fN in PATH) or slab (N slots in one file or block device)
+    std::string SLAB_PATH;  // Slab file or block device (default PATH/slab)
+    int SLAB_FDS = 0;  // Slab fd pool size (0 = one per file in flight)
+    int DIR_FANOUT = 0;  // Files layout: subdirectories per level, hashed by file number (0 = flat PATH/fI)
+    int DIR_LEVELS = 2;  // Files layout: levels of DIR_FANOUT subdirectories (e.g. PATH/ab/cd/fI)
+    std::string CACHE_STATE = "keep";  // Page cache of the file set before each measured run: keep, cold, warm or partial:<fraction>
+    bool PATH_TABLE = true;  // Files layout: build every read name up front and open it with openat()
+    bool NOATIME = false;  // Open reads with O_NOATIME (path table only; dropped if not permitted)
+    bool VERIFY = false;  // Stamp every written 4 KB block (entry, block, generation, CRC32C) and check it on read
+    int SMALL_BATCH = 0;  // sync engine: read files this many at a time, one preadv2() each (0 = off)
+    std::string RWF;  // preadv2() flags for --small_batch: nowait, hipri (comma-separated)
+    std::string RESOLVE;  // openat2() RESOLVE_* flags for reads, e.g. beneath,no_symlinks,cached (path table only)
+    std::vector<int> SWEEP_CHUNKS;  // Sweep: chunk sizes to try (empty = CHUNK_SIZE only)
+    std::vector<int> SWEEP_DEPTHS;  // Sweep: I/O depths to try (empty = 1 only)
+    std::vector<int> INFLIGHT;  // Files kept in flight; one read phase per listed value (empty = one file at a time)
+    
+    // Split command line into positional arguments and --name=value options
+    std::vector<std::string> args;
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) == 0) {
+            size_t eq = arg.find('=');
+            if (eq == std::string::npos) {
+                options.values[arg.substr(2)] = "1";
+            } else {
+                options.values[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+            }
+        } else {
+            args.push_back(arg);
+        }
+    }
     
-    // Parse command line arguments if provided
-    if (argc >= 2) N = std::stoi(argv[1]);
-    if (argc >= 3) K = std::stoll(argv[2]);
-    if (argc >= 4) ITER = std::stoi(argv[3]);
-    if (argc >= 5) PATH = argv[4];
-    if (argc >= 6) CREATE_DELETE_MODE = (std::string(argv[5]) == "1" || std::string(argv[5]) == "true");
-    if (argc >= 7) DROP_CACHE_INITIAL = (std::string(argv[6]) == "1" || std::string(argv[6]) == "true");
-    if (argc >= 8) SKIP_READ = (std::string(argv[7]) == "1" || std::string(argv[7]) == "true");
-    if (argc >= 9) SKIP_WRITE = (std::string(argv[8]) == "1" || std::string(argv[8]) == "true");
-    if (argc >= 10) CHUNK_SIZE = std::stoull(argv[9]);
-    if (argc >= 11) PARALLEL_READ = (std::string(argv[10]) == "1" || std::string(argv[10]) == "true");
+    // Parse positional arguments if provided
+    if (args.size() >= 1) N = std::stoi(args[0]);
+    if (args.size() >= 2) K = std::stoll(args[1]);
+    if (args.size() >= 3) ITER = std::stoi(args[2]);
+    if (args.size() >= 4) PATH = args[3];
+    if (args.size() >= 5) CREATE_DELETE_MODE = parse_bool(args[4]);
+    if (args.size() >= 6) DROP_CACHE_INITIAL = parse_bool(args[5]);
+    if (args.size() >= 7) SKIP_READ = parse_bool(args[6]);
+    if (args.size() >= 8) SKIP_WRITE = parse_bool(args[7]);
+    if (args.size() >= 9) CHUNK_SIZE = std::stoull(args[8]);
+    if (args.size() >= 10) PARALLEL_READ = parse_bool(args[9]);
+    
+    // --suite: run every cell of a parameter matrix as a child process and
+    // merge their reports; the positionals and other options given here are
+    // the defaults of every cell (see suite.h)
+    if (options.has("suite")) {
+        std::string SUITE = options.get("suite", "");
+        OUTPUT = options.get("output", OUTPUT);
+        OUTPUT_FILE = options.get("output_file", OUTPUT_FILE);
+        if (!OUTPUT.empty() && OUTPUT != "json" && OUTPUT != "csv") {
+            std::cerr << "Unknown output format: " << OUTPUT << " (expected json or csv)" << std::endl;
+            return 1;
+        }
+        auto flag = [](bool value) { return std::string(value ? "1" : "0"); };
+        std::vector<std::pair<std::string, std::string>> positionals = {
+            {"N", std::to_string(N)}, {"K", std::to_string(K)}, {"ITER", std::to_string(ITER)}, {"PATH", PATH},
+            {"CREATE_DELETE_MODE", flag(CREATE_DELETE_MODE)}, {"DROP_CACHE_INITIAL", flag(DROP_CACHE_INITIAL)},
+            {"SKIP_READ", flag(SKIP_READ)}, {"SKIP_WRITE", flag(SKIP_WRITE)},
+            {"CHUNK_SIZE", std::to_string(CHUNK_SIZE)}, {"PARALLEL_READ", flag(PARALLEL_READ)}};
+        SuiteRunner suite;
+        if (!suite.load(SUITE)) {
+            return 1;
+        }
+        return suite.run(argv[0], positionals, options.values, OUTPUT, OUTPUT_FILE) ? 0 : 1;
+    }
+    
+    // Parse named options
+    ENGINE = options.get("engine", ENGINE);
+    URING_POLL = options.get("uring_poll", URING_POLL);
+    SQPOLL_CPU = (int)options.get_int("sqpoll_cpu", SQPOLL_CPU);
+    SQPOLL_IDLE_MS = (int)options.get_int("sqpoll_idle_ms", SQPOLL_IDLE_MS);
+    QUEUE_DEPTH = (int)options.get_int("qd", QUEUE_DEPTH);
+    BATCH_FILES = (int)options.get_int("batch_files", BATCH_FILES);
+    POOL_THREADS = (int)options.get_int("pool_threads", POOL_THREADS);
+    POOL_QUEUE = (int)options.get_int("pool_queue", POOL_QUEUE);
+    INFLIGHT = parse_int_list(options.get("inflight", ""));
+    SWEEP_CHUNKS = parse_int_list(options.get("sweep_chunks", ""));
+    SWEEP_DEPTHS = parse_int_list(options.get("sweep_depths", ""));
+    LATENCY_JSON = options.get("latency_json", LATENCY_JSON);
+    OUTPUT = options.get("output", OUTPUT);
+    OUTPUT_FILE = options.get("output_file", OUTPUT_FILE);
+    DURATION = std::stod(options.get("duration", "0"));
+    WARMUP = options.get("warmup", WARMUP);
+    REPEAT = (int)options.get_int("repeat", REPEAT);
+    IO_STATS = options.get_bool("io_stats", IO_STATS);
+    SAMPLE_MS = (int)options.get_int("sample_ms", SAMPLE_MS);
+    SAMPLE_FILE = options.get("sample_file", SAMPLE_FILE);
+    MANAGER = options.get("manager", MANAGER);
+    MAX_INFLIGHT_REQUESTS = (int)options.get_int("max_inflight_requests", MAX_INFLIGHT_REQUESTS);
+    MAX_WRITE_WAITERS = (int)options.get_int("max_write_waiters", MAX_WRITE_WAITERS);
+    WORKERS_PER_REQUEST = (int)options.get_int("workers_per_request", WORKERS_PER_REQUEST);
+    MANAGER_O_DIRECT = options.get_bool("manager_o_direct", MANAGER_O_DIRECT);
+    LOCK_FREE_POOL = options.get_bool("lock_free_pool", LOCK_FREE_POOL);
+    POOL_SCALING = options.get_bool("pool_scaling", POOL_SCALING);
+    WRITE_PIPELINE = options.get("write_pipeline", WRITE_PIPELINE);
+    PIPELINE_WRITERS = (int)options.get_int("pipeline_writers", PIPELINE_WRITERS);
+    PIPELINE_QUEUE = (int)options.get_int("pipeline_queue", PIPELINE_QUEUE);
+    PIPELINE_BATCH = (int)options.get_int("pipeline_batch", PIPELINE_BATCH);
+    POPULATE_THREADS = (int)options.get_int("populate_threads", POPULATE_THREADS);
+    FILL = options.get("fill", FILL);
+    FALLOCATE = options.get_bool("fallocate", FALLOCATE);
+    POPULATE_O_DIRECT = options.get_bool("populate_o_direct", POPULATE_O_DIRECT);
+    WORKLOAD = options.get("workload", WORKLOAD);
+    WRITE_VARIANT = options.get("write_variant", WRITE_VARIANT);
+    WRITE_DIRECT = options.get_bool("write_direct", WRITE_DIRECT);
+    WRITE_DSYNC = options.get_bool("dsync", WRITE_DSYNC);
+    FDATASYNC_EVERY = (int)options.get_int("fdatasync_every", FDATASYNC_EVERY);
+    READERS = (int)options.get_int("readers", READERS);
+    WRITERS = (int)options.get_int("writers", WRITERS);
+    RW_RATIO = options.get("rw_ratio", RW_RATIO);
+    TRACE = options.get("trace", TRACE);
+    TRACE_CONVERT = options.get("trace_convert", TRACE_CONVERT);
+    REPLAY_SPEED = std::stod(options.get("replay_speed", std::to_string(REPLAY_SPEED)));
+    REPLAY_WORKERS = (int)options.get_int("replay_workers", REPLAY_WORKERS);
+    DISTRIBUTION = options.get("distribution", DISTRIBUTION);
+    ZIPF_THETA = std::stod(options.get("zipf_theta", std::to_string(ZIPF_THETA)));
+    HOT_FRACTION = std::stod(options.get("hot_fraction", std::to_string(HOT_FRACTION)));
+    HOT_ACCESS = std::stod(options.get("hot_access", std::to_string(HOT_ACCESS)));
+    RATE_LIMIT = std::stod(options.get("rate_limit", "0"));
+    READ_RATE_LIMIT = std::stod(options.get("read_rate_limit", "0"));
+    WRITE_RATE_LIMIT = std::stod(options.get("write_rate_limit", "0"));
+    RATE_GRANULARITY_US = options.get_int("rate_granularity_us", RATE_GRANULARITY_US);
+    FD_CACHE = options.get("fd_cache", FD_CACHE);
+    MAP_POPULATE_FLAG = options.get_bool("map_populate", MAP_POPULATE_FLAG);
+    MADVISE = options.get("madvise", MADVISE);
+    HUGE_PAGES = options.get_bool("huge_pages", HUGE_PAGES);
+    MMAP_TOUCH = options.get("mmap_touch", MMAP_TOUCH);
+    THREADS = (int)options.get_int("threads", THREADS);
+    PIN_CPUS = options.get("pin_cpus", PIN_CPUS);
+    PIN_NODES = options.get("pin_nodes", PIN_NODES);
+    ARENA_HUGE_PAGES = options.get_bool("arena_huge_pages", ARENA_HUGE_PAGES);
+    ARENA_MLOCK = options.get_bool("arena_mlock", ARENA_MLOCK);
+    LAYOUT = options.get("layout", LAYOUT);
+    SLAB_PATH = options.get("slab_path", PATH + "/slab");
+    SLAB_FDS = (int)options.get_int("slab_fds", SLAB_FDS);
+    DIR_FANOUT = (int)options.get_int("dir_fanout", DIR_FANOUT);
+    DIR_LEVELS = (int)options.get_int("dir_levels", DIR_LEVELS);
+    CACHE_STATE = options.get("cache_state", CACHE_STATE);
+    PATH_TABLE = options.get_bool("path_table", PATH_TABLE);
+    NOATIME = options.get_bool("noatime", NOATIME);
+    RESOLVE = options.get("resolve", RESOLVE);
+    SMALL_BATCH = (int)options.get_int("small_batch", SMALL_BATCH);
+    VERIFY = options.get_bool("verify", VERIFY);
+    RWF = options.get("rwf", RWF);
+    if (!options.values.empty()) {
+        std::cerr << "Unknown option: --" << options.values.begin()->first << std::endl;
+        return 1;
+    }
+    if (!OUTPUT.empty() && OUTPUT != "json" && OUTPUT != "csv") {
+        std::cerr << "Unknown output format: " << OUTPUT << " (expected json or csv)" << std::endl;
+        return 1;
+    }
+    double WARMUP_SECONDS = 0;
+    int WARMUP_ITERS = 0;
+    if (!WARMUP.empty()) {
+        if (WARMUP.back() == 's') {
+            WARMUP_SECONDS = std::stod(WARMUP.substr(0, WARMUP.size() - 1));
+        } else {
+            WARMUP_ITERS = std::stoi(WARMUP);
+        }
+    }
+    if (DURATION < 0 || WARMUP_SECONDS < 0 || WARMUP_ITERS < 0 || REPEAT < 1) {
+        std::cerr << "--duration and --warmup must not be negative and --repeat must be at least 1" << std::endl;
+        return 1;
+    }
+    if (!MANAGER.empty() && (DURATION > 0 || !WARMUP.empty() || REPEAT > 1)) {
+        std::cerr << "--duration, --warmup and --repeat apply to the main loops, not --manager" << std::endl;
+        return 1;
+    }
+    if (!WARMUP.empty() && (WORKLOAD == "mixed" || WORKLOAD == "replay")) {
+        // The warm-up pass is the plain loop, which neither mixes writes in nor knows what a replay deleted
+        std::cerr << "--warmup applies to the plain loop, not to --workload=mixed/replay" << std::endl;
+        return 1;
+    }
+    if (REPEAT > 1 && (WORKLOAD == "mixed" || WORKLOAD == "replay" || !INFLIGHT.empty() || !SWEEP_CHUNKS.empty() || !SWEEP_DEPTHS.empty())) {
+        std::cerr << "--repeat applies to the plain loop, not to --workload=mixed/replay, --inflight or a sweep" << std::endl;
+        return 1;
+    }
+    // With --duration the loops run until the deadline, cycling through the permutation
+    int RUN_ITER = DURATION > 0 ? INT_MAX : ITER;
+    std::string RUN_LENGTH = DURATION > 0 ? [&] {
+        std::ostringstream length;
+        length << DURATION << " s of";
+        return length.str();
+    }() : std::to_string(ITER);
+    if (SAMPLE_MS < 0 || (SAMPLE_MS > 0 && !MANAGER.empty())) {
+        std::cerr << "--sample_ms must not be negative and samples the main loops, not --manager" << std::endl;
+        return 1;
+    }
+    if (ENGINE != "sync" && ENGINE != "io_uring" && ENGINE != "mmap") {
+        std::cerr << "Unknown engine: " << ENGINE << " (expected sync, io_uring or mmap)" << std::endl;
+        return 1;
+    }
+    unsigned URING_SETUP = 0;
+    if (URING_POLL == "iopoll") {
+        URING_SETUP = IORING_SETUP_IOPOLL;
+    } else if (URING_POLL == "sqpoll") {
+        URING_SETUP = IORING_SETUP_SQPOLL;
+    } else if (URING_POLL == "iopoll,sqpoll" || URING_POLL == "sqpoll,iopoll") {
+        URING_SETUP = IORING_SETUP_IOPOLL | IORING_SETUP_SQPOLL;
+    } else if (URING_POLL != "none") {
+        std::cerr << "--uring_poll must be none, iopoll, sqpoll or iopoll,sqpoll" << std::endl;
+        return 1;
+    }
+    if ((URING_SETUP != 0 && ENGINE != "io_uring") || SQPOLL_IDLE_MS < 0 ||
+        (SQPOLL_CPU >= 0 && !(URING_SETUP & IORING_SETUP_SQPOLL))) {
+        std::cerr << "--uring_poll needs --engine=io_uring, --sqpoll_cpu needs --uring_poll=sqpoll "
+                  << "and --sqpoll_idle_ms must not be negative" << std::endl;
+        return 1;
+    }
+    if (ENGINE != "sync" && PARALLEL_READ) {
+        std::cerr << "PARALLEL_READ applies to the sync engine only" << std::endl;
+        return 1;
+    }
+    if (QUEUE_DEPTH < 1 || BATCH_FILES < 1) {
+        std::cerr << "--qd and --batch_files must be at least 1" << std::endl;
+        return 1;
+    }
+    if (!MANAGER.empty() && (MAX_INFLIGHT_REQUESTS < 1 || MAX_WRITE_WAITERS < 1 || WORKERS_PER_REQUEST < 1)) {
+        std::cerr << "--max_inflight_requests, --max_write_waiters and --workers_per_request must be at least 1" << std::endl;
+        return 1;
+    }
+    if (WRITE_PIPELINE != "off" && WRITE_PIPELINE != "pwrite" && WRITE_PIPELINE != "io_uring") {
+        std::cerr << "--write_pipeline must be off, pwrite or io_uring" << std::endl;
+        return 1;
+    }
+    if (PIPELINE_WRITERS == 0) PIPELINE_WRITERS = MAX_WRITE_WAITERS;
+    if (PIPELINE_QUEUE == 0) PIPELINE_QUEUE = MAX_INFLIGHT_REQUESTS * WORKERS_PER_REQUEST;
+    if (WRITE_PIPELINE != "off" && (MANAGER.empty() || PIPELINE_WRITERS < 1 || PIPELINE_QUEUE < 1 ||
+                                    PIPELINE_BATCH < 1 || PIPELINE_BATCH > 4096)) {
+        std::cerr << "--write_pipeline needs --manager, --pipeline_writers and --pipeline_queue of at least 1 "
+                  << "and --pipeline_batch 1..4096" << std::endl;
+        return 1;
+    }
+    // A writer holds a whole batch of checked-out files; all of them together must fit the file set
+    if (WRITE_PIPELINE != "off" && MANAGER != "kvc2" && (long long)PIPELINE_WRITERS * PIPELINE_BATCH > N) {
+        std::cerr << "--pipeline_writers x --pipeline_batch must not exceed N (" << N << ")" << std::endl;
+        return 1;
+    }
+    for (int depth : INFLIGHT) {
+        if (depth < 1) {
+            std::cerr << "--inflight values must be at least 1" << std::endl;
+            return 1;
+        }
+    }
+    if (WORKLOAD != "read" && WORKLOAD != "write" && WORKLOAD != "mixed" && WORKLOAD != "replay") {
+        std::cerr << "Unknown workload: " << WORKLOAD << " (expected read, write, mixed or replay)" << std::endl;
+        return 1;
+    }
+    if (WORKLOAD == "mixed") {
+        if (READERS < 0 || WRITERS < 0 || READERS + WRITERS == 0) {
+            std::cerr << "--readers and --writers must not be negative and not both 0" << std::endl;
+            return 1;
+        }
+        if (WRITE_VARIANT == "create") {
+            std::cerr << "--write_variant=create deletes files under concurrent readers; "
+                      << "use overwrite/prealloc, or --manager=filemanager for exclusive checkout" << std::endl;
+            return 1;
+        }
+        if (!INFLIGHT.empty()) {
+            std::cerr << "--inflight does not apply to the mixed workload (use --readers/--writers)" << std::endl;
+            return 1;
+        }
+    }
+    if (!RW_RATIO.empty()) {
+        size_t colon = RW_RATIO.find(':');
+        if (colon != std::string::npos) {
+            RATIO_READS = std::stoi(RW_RATIO.substr(0, colon));
+            RATIO_WRITES = std::stoi(RW_RATIO.substr(colon + 1));
+        }
+        if (RATIO_READS < 1 || RATIO_WRITES < 0) {
+            std::cerr << "--rw_ratio must look like reads:writes, e.g. 4:1" << std::endl;
+            return 1;
+        }
+    }
+    if (!FileSelector::valid_distribution(DISTRIBUTION)) {
+        std::cerr << "Unknown distribution: " << DISTRIBUTION << " (expected uniform, zipf or hotset)" << std::endl;
+        return 1;
+    }
+    if (ZIPF_THETA <= 0 || ZIPF_THETA >= 1 || HOT_FRACTION <= 0 || HOT_FRACTION > 1 ||
+        HOT_ACCESS < 0 || HOT_ACCESS > 1) {
+        std::cerr << "--zipf_theta must be in (0, 1), --hot_fraction in (0, 1] and --hot_access in [0, 1]" << std::endl;
+        return 1;
+    }
+    if (WRITE_VARIANT != "create" && WRITE_VARIANT != "overwrite" && WRITE_VARIANT != "prealloc") {
+        std::cerr << "Unknown write variant: " << WRITE_VARIANT 
+                  << " (expected create, overwrite or prealloc)" << std::endl;
+        return 1;
+    }
+    if (((WORKLOAD == "write" || WORKLOAD == "replay") && ENGINE != "sync") || (WORKLOAD == "mixed" && ENGINE == "io_uring")) {
+        std::cerr << "--workload=" << WORKLOAD << " does not run on the " << ENGINE << " engine" << std::endl;
+        return 1;
+    }
+    int MADVISE_ADVICE = -1;
+    if (MADVISE == "sequential") MADVISE_ADVICE = MADV_SEQUENTIAL;
+    else if (MADVISE == "random") MADVISE_ADVICE = MADV_RANDOM;
+    else if (MADVISE == "willneed") MADVISE_ADVICE = MADV_WILLNEED;
+    else if (MADVISE != "none") {
+        std::cerr << "Unknown madvise advice: " << MADVISE << " (expected none, sequential, random or willneed)" << std::endl;
+        return 1;
+    }
+    if (MMAP_TOUCH != "page" && MMAP_TOUCH != "all") {
+        std::cerr << "Unknown mmap touch mode: " << MMAP_TOUCH << " (expected page or all)" << std::endl;
+        return 1;
+    }
+    if (FDATASYNC_EVERY < 0) {
+        std::cerr << "--fdatasync_every must not be negative" << std::endl;
+        return 1;
+    }
+    if (FILL != "random" && FILL != "zero" && FILL != "pattern") {
+        std::cerr << "Unknown fill: " << FILL << " (expected random, zero or pattern)" << std::endl;
+        return 1;
+    }
+    if (POPULATE_THREADS < 1) {
+        std::cerr << "--populate_threads must be at least 1" << std::endl;
+        return 1;
+    }
+    if (RATE_LIMIT < 0 || READ_RATE_LIMIT < 0 || WRITE_RATE_LIMIT < 0 || RATE_GRANULARITY_US < 1) {
+        std::cerr << "Rate limits must not be negative and --rate_granularity_us must be at least 1" << std::endl;
+        return 1;
+    }
+    size_t FD_CACHE_CAPACITY = (FD_CACHE == "all") ? (size_t)N : (size_t)std::stoll(FD_CACHE);
+    if (FD_CACHE != "all" && std::stoll(FD_CACHE) < 0) {
+        std::cerr << "--fd_cache must be a capacity of at least 0 or 'all'" << std::endl;
+        return 1;
+    }
+    if (FD_CACHE_CAPACITY > 0 && WORKLOAD == "write") {
+        std::cerr << "--fd_cache applies to reads only" << std::endl;
+        return 1;
+    }
+    if (THREADS < 1) {
+        std::cerr << "--threads must be at least 1" << std::endl;
+        return 1;
+    }
+    if (THREADS > 1 && (!INFLIGHT.empty() || WORKLOAD == "mixed" || WORKLOAD == "replay" || !MANAGER.empty())) {
+        std::cerr << "--threads does not combine with --inflight, --workload=mixed/replay or --manager" << std::endl;
+        return 1;
+    }
+    if (THREADS > 1 && DISTRIBUTION == "uniform" && THREADS > N) {
+        std::cerr << "--threads must not exceed N, every thread needs files of its own" << std::endl;
+        return 1;
+    }
+    if (THREADS > 1 && DISTRIBUTION != "uniform" && WORKLOAD == "write" && WRITE_VARIANT == "create") {
+        std::cerr << "--write_variant=create needs disjoint shards, i.e. --distribution=uniform with --threads" << std::endl;
+        return 1;
+    }
+    // One CPU set per pinned thread slot
+    std::vector<std::vector<int>> CPU_SETS;
+    if (!PIN_CPUS.empty() && !PIN_NODES.empty()) {
+        std::cerr << "Use either --pin_cpus or --pin_nodes" << std::endl;
+        return 1;
+    }
+    if (!PIN_CPUS.empty()) {
+        std::vector<int> cpus;
+        if (!parse_cpu_list(PIN_CPUS, cpus) || cpus.empty()) {
+            std::cerr << "--pin_cpus must be a cpulist such as 0-3,8" << std::endl;
+            return 1;
+        }
+        for (int cpu : cpus) CPU_SETS.push_back({cpu});
+    }
+    const std::string device_path = (LAYOUT == "slab") ? SLAB_PATH : PATH;
+    if (PIN_NODES == "device") {
+        int node = device_numa_node(device_path);
+        if (node < 0) {
+            std::cout << "Warning: no NUMA node known for the device behind " << device_path
+                      << ", threads and buffers are not placed" << std::endl;
+            PIN_NODES.clear();
+        } else {
+            PIN_NODES = std::to_string(node);
+            std::cout << "Device behind " << device_path << " is on NUMA node " << node << std::endl;
+        }
+    }
+    // With a single node every thread runs there, so the buffer arena is bound
+    // to it and the main thread (and the pools and writers it starts) moves too
+    int ARENA_NODE = -1;
+    if (!PIN_NODES.empty()) {
+        std::vector<int> nodes;
+        if (!parse_cpu_list(PIN_NODES, nodes) || nodes.empty()) {
+            std::cerr << "--pin_nodes must be a list of NUMA nodes such as 0,1" << std::endl;
+            return 1;
+        }
+        for (int node : nodes) {
+            std::vector<int> cpus = numa_node_cpus(node);
+            if (cpus.empty()) {
+                std::cerr << "NUMA node " << node << " has no CPUs or does not exist" << std::endl;
+                return 1;
+            }
+            CPU_SETS.push_back(cpus);
+        }
+        if (nodes.size() == 1) {
+            ARENA_NODE = nodes[0];
+            if (!pin_current_thread(CPU_SETS[0])) return 1;
+        }
+    }
+    bool SWEEP = !SWEEP_CHUNKS.empty() || !SWEEP_DEPTHS.empty();
+    if (SWEEP) {
+        if (SWEEP_CHUNKS.empty()) SWEEP_CHUNKS.push_back((int)CHUNK_SIZE);
+        if (SWEEP_DEPTHS.empty()) SWEEP_DEPTHS.push_back(1);
+        if (WORKLOAD != "read" || ENGINE == "mmap" || !INFLIGHT.empty() || THREADS > 1 || !MANAGER.empty()) {
+            std::cerr << "--sweep_chunks/--sweep_depths sweep the read loop of the sync and io_uring engines "
+                      << "and do not combine with --inflight, --threads or --manager" << std::endl;
+            return 1;
+        }
+        for (int chunk : SWEEP_CHUNKS) {
+            if (chunk < 4096 || chunk % 4096 != 0) {
+                std::cerr << "--sweep_chunks values must be multiples of 4096 (O_DIRECT)" << std::endl;
+                return 1;
+            }
+        }
+        for (int depth : SWEEP_DEPTHS) {
+            if (depth < 1) {
+                std::cerr << "--sweep_depths values must be at least 1" << std::endl;
+                return 1;
+            }
+        }
+    }
+    if (LAYOUT != "files" && LAYOUT != "slab") {
+        std::cerr << "Unknown layout: " << LAYOUT << " (expected files or slab)" << std::endl;
+        return 1;
+    }
+    if (DIR_FANOUT != 0 && (DIR_FANOUT < 2 || DIR_FANOUT > 4096 || DIR_LEVELS < 1 || DIR_LEVELS > 4 ||
+                            std::pow((double)DIR_FANOUT, DIR_LEVELS) > (1 << 24))) {
+        std::cerr << "--dir_fanout must be 0 (flat) or 2..4096 and --dir_levels 1..4, "
+                  << "with at most 2^24 leaf directories" << std::endl;
+        return 1;
+    }
+    FileLayout FILE_LAYOUT = {PATH, DIR_FANOUT, DIR_FANOUT > 0 ? DIR_LEVELS : 0};
+    int RWF_FLAGS = 0;
+    if (!parse_rwf_flags(RWF, RWF_FLAGS)) {
+        return 1;
+    }
+    if (SMALL_BATCH < 0 || (SMALL_BATCH == 0 && RWF_FLAGS != 0)) {
+        std::cerr << "--small_batch must not be negative, and --rwf needs --small_batch" << std::endl;
+        return 1;
+    }
+    CacheControl cache_control;
+    if (!cache_control.parse(CACHE_STATE)) {
+        std::cerr << "--cache_state must be keep, cold, warm or partial:<fraction 0..1>" << std::endl;
+        return 1;
+    }
+    if (cache_control.enabled() && !MANAGER.empty()) {
+        std::cerr << "--cache_state does not combine with --manager" << std::endl;
+        return 1;
+    }
+    if ((NOATIME || !RESOLVE.empty()) && (!PATH_TABLE || LAYOUT != "files")) {
+        std::cerr << "--noatime and --resolve need the path table (--layout=files, --path_table=1)" << std::endl;
+        return 1;
+    }
+    // Files in flight at once, i.e. fds the slab layout needs
+    int max_concurrency = THREADS * ((ENGINE == "io_uring") ? BATCH_FILES : 1);
+    for (int depth : INFLIGHT) max_concurrency = std::max(max_concurrency, depth);
+    if (!PARALLEL_READ) {
+        for (int depth : SWEEP_DEPTHS) max_concurrency = std::max(max_concurrency, depth);
+    }
+    if (WORKLOAD == "mixed") max_concurrency = std::max(max_concurrency, READERS + WRITERS);
+    max_concurrency = std::max(max_concurrency, SMALL_BATCH);
+    if (LAYOUT == "slab") {
+        if (!MANAGER.empty() || FD_CACHE_CAPACITY > 0) {
+            std::cerr << "--layout=slab does not combine with --manager or --fd_cache" << std::endl;
+            return 1;
+        }
+        if (WORKLOAD != "read" && WRITE_VARIANT != "overwrite") {
+            std::cerr << "--layout=slab writes slots in place (--write_variant=overwrite)" << std::endl;
+            return 1;
+        }
+        if (SLAB_FDS < 0) {
+            std::cerr << "--slab_fds must not be negative" << std::endl;
+            return 1;
+        }
+        if (SLAB_FDS == 0) {
+            SLAB_FDS = max_concurrency;
+        }
+        // The io_uring loop runs on one thread and must never wait for an fd
+        if (ENGINE == "io_uring" && SLAB_FDS < max_concurrency) {
+            std::cerr << "--slab_fds must cover the " << max_concurrency << " files in flight on io_uring" << std::endl;
+            return 1;
+        }
+    }
+    if (POOL_THREADS < 0 || POOL_QUEUE < 0) {
+        std::cerr << "--pool_threads and --pool_queue must not be negative" << std::endl;
+        return 1;
+    }
+    if (POOL_THREADS == 0) {
+        POOL_THREADS = (int)std::max<long long>(1, (K + (long long)CHUNK_SIZE - 1) / (long long)CHUNK_SIZE);
+    }
+    if (POOL_QUEUE == 0) {
+        POOL_QUEUE = 2 * POOL_THREADS;
+    }
     
     // Assume K is already aligned to 4096 bytes
     const size_t ALIGNMENT = 4096;
     long long aligned_K = K;
+    // Slab slots are rounded up to the alignment so every slot offset suits O_DIRECT
+    long long SLOT_SIZE = (aligned_K + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    if (VERIFY) {
+        if (!MANAGER.empty() || PARALLEL_READ || SKIP_WRITE) {
+            std::cerr << "--verify does not combine with --manager, PARALLEL_READ or SKIP_WRITE" << std::endl;
+            return 1;
+        }
+        // Every read and write must start on a block so it covers whole stamped blocks
+        long long tail = aligned_K % (long long)VERIFY_BLOCK;
+        if (CHUNK_SIZE % VERIFY_BLOCK != 0 || (tail != 0 && tail < (long long)sizeof(BlockStamp))) {
+            std::cerr << "--verify needs CHUNK_SIZE a multiple of " << VERIFY_BLOCK << " and K not ending in a "
+                      << "block shorter than its " << sizeof(BlockStamp) << "-byte stamp" << std::endl;
+            return 1;
+        }
+    }
+    if (SMALL_BATCH > 0) {
+        if (ENGINE != "sync" || WORKLOAD != "read" || PARALLEL_READ || SKIP_READ || THREADS > 1 || 
+            !INFLIGHT.empty() || SWEEP || !MANAGER.empty()) {
+            std::cerr << "--small_batch reads with the sync engine on one thread and does not combine with "
+                      << "PARALLEL_READ, SKIP_READ, --threads, --inflight, sweeps or --manager" << std::endl;
+            return 1;
+        }
+        if (LAYOUT == "files" && FD_CACHE_CAPACITY < (size_t)SMALL_BATCH) {
+            std::cerr << "--small_batch takes its fds from the fd cache: --fd_cache must hold the "
+                      << SMALL_BATCH << " files of a group (or 'all')" << std::endl;
+            return 1;
+        }
+        if (LAYOUT == "slab" && SLAB_FDS < SMALL_BATCH) {
+            std::cerr << "--slab_fds must cover the " << SMALL_BATCH << " files of a --small_batch group" << std::endl;
+            return 1;
+        }
+        if (aligned_K > (long long)CHUNK_SIZE) {
+            std::cerr << "--small_batch reads each file with one preadv2(): K must not exceed CHUNK_SIZE" << std::endl;
+            return 1;
+        }
+    }
+    TraceReader trace;
+    if (WORKLOAD == "replay" || !TRACE_CONVERT.empty()) {
+        if (TRACE.empty()) {
+            std::cerr << "--workload=replay and --trace_convert need --trace=<file>" << std::endl;
+            return 1;
+        }
+        if (WORKLOAD == "replay" && (LAYOUT != "files" || FD_CACHE_CAPACITY > 0 || !INFLIGHT.empty() || SWEEP ||
+                                     !MANAGER.empty() || VERIFY || SMALL_BATCH > 0 || SKIP_READ)) {
+            std::cerr << "--workload=replay deletes and recreates files of --layout=files and does not combine "
+                      << "with --fd_cache, --inflight, sweeps, --manager, --verify, --small_batch or SKIP_READ"
+                      << std::endl;
+            return 1;
+        }
+        if (REPLAY_WORKERS < 1 || REPLAY_SPEED < 0) {
+            std::cerr << "--replay_workers must be at least 1 and --replay_speed must not be negative" << std::endl;
+            return 1;
+        }
+        if (!TRACE_CONVERT.empty()) {
+            return TraceReader::convert(TRACE, TRACE_CONVERT, N) ? 0 : 1;
+        }
+        if (!trace.open(TRACE, N)) {
+            return 1;
+        }
+    }
+    
+    // --pool_scaling: pop/add churn on both file pools at 1, 2, 4, ... threads.
+    // The sharded pool must hand every thread as wide a spread of ids as the
+    // locked one (a pool that keeps returning a thread's own ids would not).
+    if (POOL_SCALING) {
+        int max_threads = (int)std::max(1u, std::thread::hardware_concurrency());
+        std::cout << "File pool scaling (" << N << " ids, " << ITER << " pop/add pairs per thread):" << std::endl;
+        std::cout << "  threads  locked_ops/s  sharded_ops/s  speedup  locked_distinct  sharded_distinct  "
+                  << "locked_min_thread_distinct  sharded_min_thread_distinct  locked_max/mean  sharded_max/mean"
+                  << std::endl;
+        std::vector<int> thread_counts;
+        for (int threads = 1; threads < max_threads; threads *= 2) thread_counts.push_back(threads);
+        thread_counts.push_back(max_threads);
+        for (int threads : thread_counts) {
+            if (threads > N) break;
+            PoolChurn churn[2];
+            for (int sharded = 0; sharded < 2; sharded++) {
+                std::unique_ptr<RandomPopPool> pool = make_random_pop_pool(sharded, N);
+                for (int id = 0; id < N; id++) pool->add(id);
+                churn[sharded] = random_pop_pool_churn(*pool, N, threads, ITER);
+                if (pool->size() != N) {
+                    std::cerr << "Error: file pool holds " << pool->size() << " of " << N << " ids after the run" << std::endl;
+                    return 1;
+                }
+            }
+            std::cout << "  " << threads << "  " << churn[0].ops_per_sec << "  " << churn[1].ops_per_sec << "  "
+                      << churn[1].ops_per_sec / churn[0].ops_per_sec << "x  " << churn[0].distinct << "  "
+                      << churn[1].distinct << "  " << churn[0].min_thread_distinct << "  "
+                      << churn[1].min_thread_distinct << "  " << churn[0].max_per_mean << "  "
+                      << churn[1].max_per_mean << std::endl;
+            if (churn[1].min_thread_distinct < 0.9 * churn[0].min_thread_distinct) {
+                std::cerr << "Error: the sharded pool handed a thread " << churn[1].min_thread_distinct
+                          << " distinct ids where the locked pool handed at least " << churn[0].min_thread_distinct
+                          << "; its checkout is not uniform" << std::endl;
+                return 1;
+            }
+        }
+        return 0;
+    }
     
     std::cout << "Parameters:" << std::endl;
     std::cout << "  N (number of files): " << N << std::endl;
     std::cout << "  K (file size in bytes): " << K << std::endl;
     std::cout << "  ITER (iterations): " << ITER << std::endl;
+    if (DURATION > 0) std::cout << "  DURATION: " << DURATION << " seconds per measured phase" << std::endl;
+    if (!WARMUP.empty()) {
+        std::cout << "  WARMUP: " << (WARMUP_SECONDS > 0 ? WARMUP.substr(0, WARMUP.size() - 1) + " seconds"
+                                                         : WARMUP + " iterations") << " (discarded)" << std::endl;
+    }
+    if (REPEAT > 1) std::cout << "  REPEAT: " << REPEAT << " runs" << std::endl;
     std::cout << "  PATH (directory): " << PATH << std::endl;
     std::cout << "  CHUNK_SIZE (read chunk size): " << CHUNK_SIZE << " bytes" << std::endl;
     std::cout << "  PARALLEL_READ: " << (PARALLEL_READ ? "enabled" : "disabled (sequential)") << std::endl;
+    if (PARALLEL_READ) {
+        std::cout << "  POOL_THREADS: " << POOL_THREADS << std::endl;
+        std::cout << "  POOL_QUEUE: " << POOL_QUEUE << std::endl;
+    }
+    std::cout << "  ENGINE: " << ENGINE << std::endl;
+    if (ENGINE == "mmap") {
+        std::cout << "  MMAP: madvise " << MADVISE << (MAP_POPULATE_FLAG ? ", MAP_POPULATE" : "") 
+                  << (HUGE_PAGES ? ", MADV_HUGEPAGE" : "") << ", touch " 
+                  << (MMAP_TOUCH == "all" ? "every word" : "one byte per page") << std::endl;
+    }
+    std::cout << "  WORKLOAD: " << WORKLOAD << std::endl;
+    std::cout << "  DISTRIBUTION: " << DISTRIBUTION;
+    if (DISTRIBUTION == "zipf") std::cout << " (theta " << ZIPF_THETA << ")";
+    if (DISTRIBUTION == "hotset") std::cout << " (" << HOT_ACCESS * 100 << "% of accesses to " << HOT_FRACTION * 100 << "% of files)";
+    std::cout << std::endl;
+    if (ENGINE == "io_uring") {
+        std::cout << "  QUEUE_DEPTH: " << QUEUE_DEPTH << std::endl;
+        std::cout << "  BATCH_FILES: " << BATCH_FILES << std::endl;
+        if (URING_SETUP != 0) {
+            std::cout << "  URING_POLL: " << URING_POLL;
+            if (URING_SETUP & IORING_SETUP_SQPOLL) {
+                std::cout << " (SQ thread " << (SQPOLL_CPU >= 0 ? "on CPU " + std::to_string(SQPOLL_CPU) : "unbound")
+                          << ", idle " << SQPOLL_IDLE_MS << " ms)";
+            }
+            std::cout << std::endl;
+        }
+    }
+    RateLimiter rate_limiter(RATE_LIMIT, READ_RATE_LIMIT, WRITE_RATE_LIMIT, RATE_GRANULARITY_US * 1000);
+    if (rate_limiter.enabled()) {
+        std::cout << "  RATE_LIMIT: shared " << (long long)RATE_LIMIT << ", read " << (long long)READ_RATE_LIMIT 
+                  << ", write " << (long long)WRITE_RATE_LIMIT << " bytes/sec (refill every " 
+                  << RATE_GRANULARITY_US << " us)" << std::endl;
+    }
+    std::cout << "  LAYOUT: " << LAYOUT;
+    if (LAYOUT == "slab") {
+        std::cout << " (" << SLAB_PATH << ", " << SLOT_SIZE << " byte slots, " << SLAB_FDS << " fds)";
+    } else if (FILE_LAYOUT.sharded()) {
+        std::cout << " (sharded: " << FILE_LAYOUT.levels << " levels of " << FILE_LAYOUT.fanout << " directories, " 
+                  << FILE_LAYOUT.num_directories() << " leaf directories)";
+    } else {
+        std::cout << " (flat: one directory)";
+    }
+    std::cout << std::endl;
+    if (FD_CACHE_CAPACITY > 0) {
+        std::cout << "  FD_CACHE: " << (FD_CACHE == "all" ? "all " + std::to_string(N) + " files opened up front" 
+                                                          : "LRU of " + FD_CACHE + " fds") << std::endl;
+    }
+    if (THREADS > 1 || !CPU_SETS.empty()) {
+        std::cout << "  THREADS: " << THREADS;
+        if (!PIN_CPUS.empty()) std::cout << " (pinned to CPUs " << PIN_CPUS << ")";
+        if (!PIN_NODES.empty()) std::cout << " (pinned to NUMA nodes " << PIN_NODES << ")";
+        std::cout << std::endl;
+    }
+    if (SWEEP) {
+        std::cout << "  SWEEP: chunk sizes";
+        for (int chunk : SWEEP_CHUNKS) std::cout << " " << chunk;
+        std::cout << ", depths";
+        for (int depth : SWEEP_DEPTHS) std::cout << " " << depth;
+        std::cout << (ENGINE == "io_uring" ? " (queue depth and files in flight)" 
+                      : PARALLEL_READ ? " (reader pool threads)" : " (files in flight)") << std::endl;
+    }
+    if (SMALL_BATCH > 0) {
+        std::cout << "  SMALL_BATCH: " << SMALL_BATCH << " files per group, one preadv2() each" 
+                  << (RWF.empty() ? "" : " (RWF: " + RWF + ")") << std::endl;
+    }
+    if (!INFLIGHT.empty()) {
+        std::cout << "  INFLIGHT:";
+        for (int depth : INFLIGHT) std::cout << " " << depth;
+        std::cout << std::endl;
+    }
     std::cout << "  CREATE_DELETE_MODE: " << (CREATE_DELETE_MODE ? "enabled (delete and create files)" : "disabled (use existing files)") << std::endl;
     std::cout << "  DROP_CACHE_INITIAL: " << (DROP_CACHE_INITIAL ? "enabled (requires root)" : "disabled") << std::endl;
+    if (VERIFY) {
+        std::cout << "  VERIFY: stamped 4 KB blocks, CRC32C checked on every read" 
+                  << (CREATE_DELETE_MODE ? "" : " (the existing file set must have been created with --verify)")
+                  << std::endl;
+    }
+    if (WORKLOAD == "replay") {
+        std::cout << "  TRACE: " << TRACE << " (" << trace.format() << "), speed " << REPLAY_SPEED
+                  << (REPLAY_SPEED > 0 ? "x" : " (back to back)") << ", " << REPLAY_WORKERS << " workers" << std::endl;
+    }
+    if (cache_control.enabled()) {
+        std::cout << "  CACHE_STATE: " << CACHE_STATE << " (per file, before each measured run)" << std::endl;
+    }
     std::cout << "  SKIP_READ: " << (SKIP_READ ? "enabled (only open/close)" : "disabled (full read)") << std::endl;
     std::cout << "  SKIP_WRITE: " << (SKIP_WRITE ? "enabled (create empty files)" : "disabled (write data)") << std::endl;
     std::cout << std::endl;
     
+    // Every parameter as it took effect, for --output
+    ResultReport report;
+    report.param("N", std::to_string(N));
+    report.param("K", std::to_string(K));
+    report.param("ITER", std::to_string(ITER));
+    report.param("PATH", PATH);
+    report.param("CREATE_DELETE_MODE", CREATE_DELETE_MODE ? "1" : "0");
+    report.param("DROP_CACHE_INITIAL", DROP_CACHE_INITIAL ? "1" : "0");
+    report.param("SKIP_READ", SKIP_READ ? "1" : "0");
+    report.param("SKIP_WRITE", SKIP_WRITE ? "1" : "0");
+    report.param("CHUNK_SIZE", std::to_string(CHUNK_SIZE));
+    report.param("PARALLEL_READ", PARALLEL_READ ? "1" : "0");
+    for (const auto& option : options.resolved) report.param(option.first, option.second);
+    report.param("pool_threads", std::to_string(POOL_THREADS));
+    report.param("pool_queue", std::to_string(POOL_QUEUE));
+    report.param("slab_fds", std::to_string(SLAB_FDS));
+    
+    // Histograms of every measured run, for --latency_json and --output
+    std::vector<LatencyRun> latency_runs;
+    std::unique_ptr<IntervalSampler> sampler;
+    if (SAMPLE_MS > 0) {
+        sampler = std::make_unique<IntervalSampler>(SAMPLE_MS);
+        progress_lines = false;
+    }
+    // --verify: generations of the last completed write per entry, and the check counts
+    Verifier verifier;
+    if (VERIFY) verifier.init(N);
+    
+    auto write_results = [&]() {
+        if (sampler) {
+            sampler->stop();
+            if (SAMPLE_FILE.empty()) {
+                sampler->print();
+            } else if (!sampler->write_csv(SAMPLE_FILE)) {
+                return false;
+            }
+        }
+        if (!LATENCY_JSON.empty() && !write_latency_json(LATENCY_JSON, ENGINE, latency_runs)) {
+            return false;
+        }
+        if (!OUTPUT.empty() && !report.write(OUTPUT, OUTPUT_FILE, PATH, latency_runs)) {
+            return false;
+        }
+        if (VERIFY) {
+            verifier.print();
+            return !verifier.failed();
+        }
+        return true;
+    };
+    
+    // Manager mode: N files of K bytes in PATH, ITER requests, CREATE_DELETE_MODE recreates PATH
+    if (!MANAGER.empty()) {
+        // With the pipeline, every write of every batch may be outstanding at once (KVC2 sizes its fds by it)
+        int write_waiters = (WRITE_PIPELINE == "off") ? MAX_WRITE_WAITERS : PIPELINE_WRITERS * PIPELINE_BATCH;
+        ManagerConfig manager_cfg = {PATH, N, K, WORKERS_PER_REQUEST, write_waiters,
+                                     MAX_INFLIGHT_REQUESTS, MANAGER_O_DIRECT, LOCK_FREE_POOL,
+                                     rate_limiter.enabled() ? &rate_limiter : nullptr, FILE_LAYOUT};
+        std::unique_ptr<BaseFileManager> manager = make_file_manager(MANAGER, manager_cfg);
+        if (!manager) {
+            std::cerr << "Unknown manager: " << MANAGER << ". Must be 'kvc2', 'filemanager', "
+                      << "'filemanagernoeviction', or 'filemanagernoevictionnoopen'" << std::endl;
+            return 1;
+        }
+        std::cout << "Manager: " << MANAGER << " (max inflight requests " << MAX_INFLIGHT_REQUESTS 
+                  << ", max write waiters " << MAX_WRITE_WAITERS << ", workers per request " 
+                  << WORKERS_PER_REQUEST << ", " << (MANAGER_O_DIRECT ? "O_DIRECT" : "buffered") 
+                  << " I/O, " << (LOCK_FREE_POOL ? "sharded" : "locked") << " file pool)" << std::endl;
+        std::unique_ptr<WritePipeline> pipeline;
+        if (WRITE_PIPELINE != "off") {
+            pipeline = std::make_unique<WritePipeline>(*manager, PIPELINE_WRITERS, PIPELINE_QUEUE, PIPELINE_BATCH,
+                                                       WRITE_PIPELINE == "io_uring");
+            std::cout << "Write pipeline: " << WRITE_PIPELINE << ", " << PIPELINE_WRITERS << " writers, queue of " 
+                      << PIPELINE_QUEUE << ", batches of up to " << PIPELINE_BATCH << std::endl;
+        }
+        std::cout << "Setting up file manager..." << std::endl;
+        auto start_setup = Clock::now();
+        if (!manager->init(CREATE_DELETE_MODE)) {
+            return 1;
+        }
+        double setup_ms = elapsed_us(start_setup, Clock::now()) / 1000.0;
+        report.timing_ms("setup", setup_ms);
+        std::cout << "Setup done in " << setup_ms << " ms" << std::endl;
+        std::cout << std::endl;
+        LatencyRun run{0, PhaseHistograms()};
+        if (!run_manager_benchmark(*manager, manager_cfg, ITER, pipeline.get(), run)) {
+            return 1;
+        }
+        latency_runs.push_back(run);
+        return write_results() ? 0 : 1;
+    }
+    
+    // Device counters of the storage behind the file set (or the slab)
+    IoAccounting io_accounting;
+    auto init_io_accounting = [&]() {
+        if (!IO_STATS) return;
+        if (io_accounting.init(device_path)) {
+            std::cout << "I/O accounting: device " << io_accounting.device() << " behind " << device_path << std::endl;
+        } else {
+            std::cout << "I/O accounting: no block device behind " << device_path 
+                      << ", process counters only" << std::endl;
+        }
+    };
+    
     if (CREATE_DELETE_MODE) {
         // Delete all content in PATH directory if it exists
         try {
@@ -78,52 +2428,48 @@ int main(int argc, char* argv[]) {
             std::cerr << "Error creating directory: " << e.what() << std::endl;
             return 1;
         }
+        if (LAYOUT == "files" && FILE_LAYOUT.sharded()) {
+            auto start_dirs = Clock::now();
+            if (!FILE_LAYOUT.create_directories()) {
+                return 1;
+            }
+            double dirs_ms = elapsed_us(start_dirs, Clock::now()) / 1000.0;
+            report.timing_ms("create_directories", dirs_ms);
+            std::cout << "Created " << FILE_LAYOUT.num_directories() << " shard directories in " 
+                      << dirs_ms << " ms" << std::endl;
+        }
         std::cout << std::endl;
         
-        // Step 1: Create N files, each of size aligned_K bytes
-        std::cout << "Creating " << N << " files..." << std::endl;
+        // Step 1: Create N files, each of size aligned_K bytes (slab: N slots)
+        std::cout << "Creating " << N << (LAYOUT == "slab" ? " slab slots in " + SLAB_PATH : " files") 
+                  << " (" << POPULATE_THREADS << " threads, " 
+                  << (SKIP_WRITE ? "no data" : FILL + " fill") << (FALLOCATE ? ", fallocate" : "") 
+                  << (POPULATE_O_DIRECT ? ", O_DIRECT" : "") << ")..." << std::endl;
+        init_io_accounting();
+        IoCounters io_before_create = io_accounting.snapshot();
         auto start_create = std::chrono::high_resolution_clock::now();
         
-        for (int i = 1; i <= N; i++) {
-            std::string filename = PATH + "/f" + std::to_string(i);
-            
-            if (!SKIP_WRITE) {
-                // Use dd to copy from /dev/urandom directly to file (no intermediate buffer in our code)
-                // Since aligned_K is already aligned to 4096 bytes, use bs=4096
-                std::string cmd = "dd if=/dev/urandom of=\"" + filename + 
-                                  "\" bs=4096 count=" + std::to_string(aligned_K / 4096) +
-                                  " iflag=fullblock status=none 2>&1";
-                int ret = system(cmd.c_str());
-                if (ret != 0) {
-                    std::cerr << "Error creating file with dd: " << filename << std::endl;
-                    return 1;
-                }
-            } else {
-                // Just create empty file
-                int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
-                if (fd == -1) {
-                    std::cerr << "Error creating file: " << filename << std::endl;
-                    return 1;
-                }
-                close(fd);
-            }
-            
-            // Print progress every 1000 files
-            if (i % 1000 == 0) {
-                auto current_time = std::chrono::high_resolution_clock::now();
-                auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(current_time - start_create);
-                double avg_time = elapsed_ms.count() / (double)i;
-                std::cout << "  Created " << i << " files, avg time per file: " 
-                          << avg_time << " ms" << std::endl;
-            }
+        PopulateConfig populate_cfg = {N, aligned_K, POPULATE_THREADS, FILL, !SKIP_WRITE,
+                                       FALLOCATE, POPULATE_O_DIRECT, VERIFY};
+        bool populated = (LAYOUT == "slab")
+            ? populate_slab(populate_cfg, SLAB_PATH, SLOT_SIZE)
+            : populate_files(populate_cfg, [&](int i) { return FILE_LAYOUT.path(i); });
+        if (!populated) {
+            return 1;
         }
         
         auto end_create = std::chrono::high_resolution_clock::now();
         auto duration_create = std::chrono::duration_cast<std::chrono::milliseconds>(end_create - start_create);
+        report.timing_ms("create", std::chrono::duration<double, std::milli>(end_create - start_create).count());
+        const char* created_what = (LAYOUT == "slab") ? " slab slots" : " files";
         if (SKIP_WRITE) {
-            std::cout << "Created " << N << " files (without writing data) in " << duration_create.count() << " ms" << std::endl;
+            std::cout << "Created " << N << created_what << " (without writing data) in " << duration_create.count() << " ms" << std::endl;
         } else {
-            std::cout << "Created " << N << " files in " << duration_create.count() << " ms" << std::endl;
+            std::cout << "Created " << N << created_what << " in " << duration_create.count() << " ms" << std::endl;
+        }
+        if (IO_STATS) {
+            io_accounting.print(io_accounting.snapshot() - io_before_create, SKIP_WRITE ? 0 : (long long)N * aligned_K,
+                                std::chrono::duration<double>(end_create - start_create).count());
         }
         std::cout << std::endl;
     }
@@ -131,10 +2477,12 @@ int main(int argc, char* argv[]) {
     // Drop cache at the beginning if requested
     if (DROP_CACHE_INITIAL) {
         std::cout << "Dropping all caches (requires root privileges)..." << std::endl;
+        auto start_drop = Clock::now();
         std::ofstream drop_cache("/proc/sys/vm/drop_caches");
         if (drop_cache) {
             drop_cache << "3" << std::endl;  // Drop all caches
             drop_cache.close();
+            report.timing_ms("drop_cache", elapsed_us(start_drop, Clock::now()) / 1000.0);
             std::cout << "Cache dropped successfully." << std::endl;
         } else {
             std::cerr << "Error: Could not drop cache. Need root privileges (run with sudo)." << std::endl;
@@ -143,25 +2491,82 @@ int main(int argc, char* argv[]) {
         std::cout << std::endl;
     }
     
+    if (!CREATE_DELETE_MODE) init_io_accounting();
+    
     // Step 2: Perform ITER iterations with O_DIRECT
-    if (SKIP_READ) {
-        std::cout << "Starting " << ITER << " iterations (open/close only)..." << std::endl;
+    if (WORKLOAD == "replay") {
+        std::cout << "Starting trace replay of " << TRACE << " on " << REPLAY_WORKERS << " workers ("
+                  << (REPLAY_SPEED > 0 ? "open loop at " + std::to_string(REPLAY_SPEED) + "x the recorded rate"
+                                       : "back to back") << ")..." << std::endl;
+    } else if (WORKLOAD == "mixed") {
+        std::cout << "Starting mixed workload: " << RUN_LENGTH << " reads on " << READERS << " readers, " 
+                  << WRITERS << " writers (" << WRITE_VARIANT << ", " << (WRITE_DIRECT ? "O_DIRECT" : "buffered")
+                  << (RW_RATIO.empty() ? ", unpaced" : ", read:write " + RW_RATIO) << ")..." << std::endl;
+    } else if (WORKLOAD == "write") {
+        std::cout << "Starting " << RUN_LENGTH << " write iterations (" << WRITE_VARIANT << ", " 
+                  << (WRITE_DIRECT ? "O_DIRECT" : "buffered") << (WRITE_DSYNC ? ", O_DSYNC" : "");
+        if (FDATASYNC_EVERY > 0) std::cout << ", fdatasync every " << FDATASYNC_EVERY << " writes";
+        std::cout << ")..." << std::endl;
+    } else if (SKIP_READ) {
+        std::cout << "Starting " << RUN_LENGTH << " iterations (open/close only)..." << std::endl;
+    } else if (ENGINE == "mmap") {
+        std::cout << "Starting " << RUN_LENGTH << " iterations with mmap..." << std::endl;
+    } else if (ENGINE == "io_uring") {
+        std::cout << "Starting " << RUN_LENGTH << " iterations with O_DIRECT (io_uring: queue depth " 
+                  << QUEUE_DEPTH << ", " << BATCH_FILES << " files per batch)..." << std::endl;
     } else if (PARALLEL_READ) {
-        long long num_chunks = aligned_K / CHUNK_SIZE;
-        std::cout << "Starting " << ITER << " iterations with O_DIRECT (parallel: " 
-                  << num_chunks << " threads per file)..." << std::endl;
+        long long num_chunks = (aligned_K + (long long)CHUNK_SIZE - 1) / (long long)CHUNK_SIZE;
+        std::cout << "Starting " << RUN_LENGTH << " iterations with O_DIRECT (parallel: " 
+                  << num_chunks << " chunk reads per file on " << POOL_THREADS 
+                  << " pool threads)..." << std::endl;
     } else {
-        std::cout << "Starting " << ITER << " iterations with O_DIRECT..." << std::endl;
+        std::cout << "Starting " << RUN_LENGTH << " iterations with O_DIRECT..." << std::endl;
+    }
+    
+    // Every chunk buffer comes from one arena mapped here, sized for the
+    // loop that needs the most at once, so no loop allocates
+    size_t loop_buffers = 1;
+    for (int depth : INFLIGHT) loop_buffers = std::max<size_t>(loop_buffers, depth);
+    if (WORKLOAD == "mixed") loop_buffers = std::max<size_t>(loop_buffers, READERS + WRITERS);
+    if (WORKLOAD == "replay") loop_buffers = std::max<size_t>(loop_buffers, REPLAY_WORKERS);
+    loop_buffers = std::max<size_t>(loop_buffers, THREADS);
+    if (ENGINE == "io_uring") loop_buffers = (size_t)QUEUE_DEPTH * THREADS;
+    loop_buffers = std::max<size_t>(loop_buffers, SMALL_BATCH);
+    size_t arena_buffers = 1 + loop_buffers + (WORKLOAD != "read" ? 1 : 0) + (PARALLEL_READ ? POOL_THREADS : 0);
+    size_t arena_buffer_size = CHUNK_SIZE;
+    for (int chunk : SWEEP_CHUNKS) arena_buffer_size = std::max<size_t>(arena_buffer_size, chunk);
+    for (int depth : SWEEP_DEPTHS) {
+        // A sweep point also needs its depth in buffers (loop or pool threads)
+        arena_buffers = std::max<size_t>(arena_buffers, 1 + loop_buffers + (PARALLEL_READ ? POOL_THREADS : 0) + depth);
+    }
+    BufferArena buffer_arena;
+    if (!buffer_arena.init(arena_buffers, arena_buffer_size, ALIGNMENT, ARENA_HUGE_PAGES, ARENA_MLOCK,
+                           ARENA_NODE)) {
+        return 1;
     }
+    std::cout << "Buffer arena: " << arena_buffers << " x " << buffer_arena.buffer_size() << " bytes (" 
+              << buffer_arena.backed_by() << (buffer_arena.is_locked() ? ", mlocked" : "")
+              << (buffer_arena.node() >= 0 ? ", NUMA node " + std::to_string(buffer_arena.node()) : "") << ")"
+              << std::endl;
     
     // Use chunk-based reading for large files
-    // Allocate aligned buffer for O_DIRECT (only for one chunk at a time)
-    void* read_buffer_raw;
-    if (posix_memalign(&read_buffer_raw, ALIGNMENT, CHUNK_SIZE) != 0) {
-        std::cerr << "Error allocating aligned buffer" << std::endl;
+    // Aligned buffer for O_DIRECT (only for one chunk at a time)
+    char* read_buffer = buffer_arena.acquire();
+    
+    // Source data for the write workload, shared read-only by all writers
+    char* write_buffer = nullptr;
+    if (WORKLOAD != "read") {
+        write_buffer = buffer_arena.acquire();
+        uint64_t rng_state = std::random_device{}();
+        populate_fill_buffer(write_buffer, CHUNK_SIZE, "random", rng_state);
+    }
+    
+    // Reader threads and their buffers are set up once, outside the measured loop
+    ReaderPool reader_pool;
+    if (PARALLEL_READ && !reader_pool.start(POOL_THREADS, buffer_arena, POOL_QUEUE)) {
+        std::cerr << "Error setting up reader pool buffers" << std::endl;
         return 1;
     }
-    char* read_buffer = static_cast<char*>(read_buffer_raw);
     
     // Create a permutation of file indices 1..N
     std::vector<int> file_permutation(N);
@@ -175,132 +2580,510 @@ int main(int argc, char* argv[]) {
     
     std::cout << "Created random permutation of " << N << " files" << std::endl;
     
-    auto start_read = std::chrono::high_resolution_clock::now();
-    long long total_bytes_read = 0;
+    // With a skewed distribution the permutation ranks popularity; the plain
+    // loops then walk ITER draws instead of cycling through the permutation.
+    // A --duration run has no fixed length, so its loops draw every access.
+    FileSelector selector(DISTRIBUTION, file_permutation, ZIPF_THETA, HOT_FRACTION, HOT_ACCESS);
+    bool draw_each = DISTRIBUTION != "uniform" && WORKLOAD != "mixed" && WORKLOAD != "replay" && DURATION > 0;
+    if (draw_each) {
+        std::cout << "Drawing every file access from the " << DISTRIBUTION << " distribution" << std::endl;
+    } else if (DISTRIBUTION != "uniform" && WORKLOAD != "mixed" && WORKLOAD != "replay") {
+        std::mt19937_64 draw_gen(rd());
+        std::vector<int> draws(ITER);
+        for (auto& file_num : draws) file_num = selector.next(draw_gen);
+        file_permutation.swap(draws);
+        std::cout << "Drew " << ITER << " file accesses from the " << DISTRIBUTION << " distribution" << std::endl;
+    }
     
-    for (int i = 0; i < ITER; i++) {
-        // Use permutation to access files in random order
-        int file_num = file_permutation[i % N];
-        std::string filename = PATH + "/f" + std::to_string(file_num);
-        
-        // 1. Open file i with O_DIRECT flag
-        int fd = open(filename.c_str(), O_RDONLY | O_DIRECT);
-        
-        if (fd == -1) {
-            std::cerr << "Error opening file with O_DIRECT: " << filename 
-                      << " (errno: " << errno << ")" << std::endl;
-            // Try without O_DIRECT as fallback
-            fd = open(filename.c_str(), O_RDONLY);
-            if (fd == -1) {
-                std::cerr << "Error opening file: " << filename << std::endl;
-                free(read_buffer);
+    // Every read name built once, opened relative to a held directory fd
+    std::unique_ptr<PathTable> path_table;
+    if (PATH_TABLE && LAYOUT == "files" && MANAGER.empty() && WORKLOAD != "write") {
+        path_table = std::make_unique<PathTable>();
+        if (!path_table->init(FILE_LAYOUT, N, NOATIME, RESOLVE, 256)) {
+            return 1;
+        }
+        std::cout << "Path table: " << N << " names in " << path_table->bytes() << " bytes, "
+                  << path_table->dir_count() << " directory fds"
+                  << (path_table->uses_openat2() ? ", openat2 --resolve=" + RESOLVE : ", openat")
+                  << (path_table->uses_noatime() ? ", O_NOATIME" : "") << std::endl;
+    }
+    
+    // Keep-open fds: "all" opens every file now so the loop never calls open()
+    std::unique_ptr<FdCache> fd_cache;
+    if (FD_CACHE_CAPACITY > 0) {
+        if (!ensure_fd_limit(FD_CACHE_CAPACITY + (path_table ? path_table->dir_count() : 0))) {
+            return 1;
+        }
+        fd_cache = std::make_unique<FdCache>(FD_CACHE_CAPACITY, [&](int file_num) {
+            return path_table ? open_for_read(*path_table, file_num) : open_for_read(FILE_LAYOUT.path(file_num));
+        });
+        if (FD_CACHE == "all") {
+            auto start_open = Clock::now();
+            std::vector<int> all_files(N);
+            for (int i = 0; i < N; i++) all_files[i] = i + 1;
+            if (!fd_cache->preload(all_files)) {
                 return 1;
             }
-            std::cout << "Warning: O_DIRECT not supported, reading without it" << std::endl;
+            fd_cache->reset_stats();
+            std::cout << "Opened " << N << " files in " << elapsed_us(start_open, Clock::now()) / 1000.0 
+                      << " ms" << std::endl;
         }
-        
-        // 2. Read all content of file i
-        ssize_t file_total_read = 0;
-        
-        if (!SKIP_READ) {
-            if (PARALLEL_READ) {
-                // Parallel reading: issue file_size/chunk_size parallel reads
-                long long num_chunks = aligned_K / CHUNK_SIZE;
-                std::atomic<bool> error_occurred(false);
-                std::atomic<long long> total_read(0);
-                std::vector<std::thread> threads;
-                
-                for (long long chunk_idx = 0; chunk_idx < num_chunks; chunk_idx++) {
-                    threads.emplace_back([&, chunk_idx]() {
-                        off_t offset = chunk_idx * CHUNK_SIZE;
-                        
-                        // Allocate thread-local aligned buffer
-                        void* thread_buffer_raw;
-                        if (posix_memalign(&thread_buffer_raw, ALIGNMENT, CHUNK_SIZE) != 0) {
-                            error_occurred = true;
-                            return;
-                        }
-                        char* thread_buffer = static_cast<char*>(thread_buffer_raw);
-                        
-                        // Use pread to read from specific offset
-                        ssize_t bytes_read = pread(fd, thread_buffer, CHUNK_SIZE, offset);
-                        if (bytes_read != (ssize_t)CHUNK_SIZE) {
-                            error_occurred = true;
-                        } else {
-                            total_read += bytes_read;
-                        }
-                        
-                        free(thread_buffer);
-                    });
-                }
-                
-                // Wait for all threads to complete
-                for (auto& thread : threads) {
-                    thread.join();
-                }
-                
-                if (error_occurred) {
-                    std::cerr << "Error in parallel read of file " << filename << std::endl;
-                    close(fd);
-                    free(read_buffer);
+    }
+    
+    // A mapping beyond EOF faults with SIGBUS, so check the file size once up front
+    if (ENGINE == "mmap" && LAYOUT == "files" && N > 0) {
+        struct stat st;
+        std::string first_file = FILE_LAYOUT.path(1);
+        if (stat(first_file.c_str(), &st) != 0 || st.st_size < aligned_K) {
+            std::cerr << "Error: " << first_file << " is missing or smaller than K; the mmap engine "
+                      << "needs files of at least K bytes (run with CREATE_DELETE_MODE=1)" << std::endl;
+            return 1;
+        }
+    }
+    
+    // Slab layout: the fd pool is opened once, like the fd queue of KVC2
+    std::unique_ptr<Slab> slab;
+    if (LAYOUT == "slab") {
+        slab = std::make_unique<Slab>();
+        bool direct = (WORKLOAD == "read") || WRITE_DIRECT;
+        if (!slab->open(SLAB_PATH, N, SLOT_SIZE, SLAB_FDS, WORKLOAD != "read", direct, WRITE_DSYNC)) {
+            return 1;
+        }
+    }
+    
+    LoopConfig loop_cfg = {FILE_LAYOUT, aligned_K, CHUNK_SIZE, SKIP_READ, PARALLEL_READ, QUEUE_DEPTH,
+                           URING_SETUP, SQPOLL_CPU, (unsigned)SQPOLL_IDLE_MS,
+                           rate_limiter.enabled() ? &rate_limiter : nullptr, WORKLOAD == "write",
+                           WRITE_VARIANT, WRITE_DIRECT, WRITE_DSYNC, FDATASYNC_EVERY, write_buffer,
+                           fd_cache.get(), path_table.get(), slab.get(), ENGINE == "mmap", MAP_POPULATE_FLAG, MADVISE_ADVICE,
+                           HUGE_PAGES, MMAP_TOUCH == "all", &buffer_arena, sampler.get(),
+                           VERIFY ? &verifier : nullptr, Clock::time_point(), draw_each ? &selector : nullptr};
+    fill_stamp_buffer(loop_cfg, read_buffer);
+    const char* bytes_label = (WORKLOAD == "write") ? "written" : "read";
+    
+    // One pass of the plain loop: sharded threads, io_uring batches or the sync
+    // engine file by file. Used for the --warmup pass and every --repeat run.
+    auto run_plain = [&](const LoopConfig& run_cfg, int iterations, Clock::time_point start_read,
+                         long long& total_bytes_read, PhaseHistograms& hist,
+                         std::vector<ShardResult>& shard_results) {
+        if (THREADS > 1 || !CPU_SETS.empty()) {
+            if (!sharded_loop(run_cfg, file_permutation, iterations, THREADS, CPU_SETS, ENGINE == "io_uring",
+                              BATCH_FILES, reader_pool, start_read, shard_results)) {
+                return false;
+            }
+            for (const auto& result : shard_results) {
+                total_bytes_read += result.bytes;
+                hist.merge(result.hist);
+            }
+            return true;
+        }
+        if (ENGINE == "io_uring") {
+            return io_uring_read_loop(run_cfg, file_permutation, iterations, BATCH_FILES, false, start_read,
+                                      total_bytes_read, hist);
+        }
+        if (SMALL_BATCH > 0) {
+            return small_batch_read_loop(run_cfg, file_permutation, iterations, SMALL_BATCH, RWF_FLAGS, start_read,
+                                         total_bytes_read, hist);
+        }
+        for (int i = 0; i < iterations && !out_of_time(run_cfg); i++) {
+            // Use permutation to access files in random order
+            int file_num = loop_file(run_cfg, file_permutation, i);
+            long long file_total_read = sync_file_op(run_cfg, file_num, i, read_buffer, reader_pool, hist);
+            if (file_total_read < 0) {
+                return false;
+            }
+            total_bytes_read += file_total_read;
+            
+            // Print progress every 1000 iterations
+            if ((i + 1) % 1000 == 0) {
+                print_progress(i + 1, start_read);
+            }
+        }
+        return true;
+    };
+    
+    // --warmup: a pass whose stats are discarded, so the measured runs start
+    // with warm page cache, device and fd cache instead of cold-start effects
+    if (!WARMUP.empty()) {
+        LoopConfig warmup_cfg = loop_cfg;
+        warmup_cfg.sampler = nullptr;
+        if (WARMUP_SECONDS > 0) warmup_cfg.deadline = deadline_after(WARMUP_SECONDS);
+        std::cout << "Warming up..." << std::endl;
+        auto start_warmup = Clock::now();
+        long long warmup_bytes = 0;
+        PhaseHistograms warmup_hist;
+        std::vector<ShardResult> warmup_shards;
+        if (!run_plain(warmup_cfg, WARMUP_SECONDS > 0 ? INT_MAX : WARMUP_ITERS, start_warmup, warmup_bytes,
+                       warmup_hist, warmup_shards)) {
+            return 1;
+        }
+        std::cout << "Warm-up: " << warmup_hist.file.count() << " files in " 
+                  << elapsed_us(start_warmup, Clock::now()) / 1000.0 << " ms (discarded)" << std::endl;
+        if (fd_cache) fd_cache->reset_stats();
+    }
+    
+    // --cache_state: evict or prefetch the file set itself, then check what stuck
+    auto set_cache_state = [&]() {
+        if (!cache_control.enabled()) return true;
+        auto extent_of = [&](int file_num) -> CacheControl::Extent {
+            if (slab) return {slab->name(), slab->slot_offset(file_num), K};
+            return {FILE_LAYOUT.path(file_num), 0, K};
+        };
+        auto start_cache = Clock::now();
+        if (!cache_control.apply(N, extent_of)) {
+            return false;
+        }
+        double cache_ms = elapsed_us(start_cache, Clock::now()) / 1000.0;
+        report.timing_ms("cache_state", cache_ms);
+        CacheControl::Residency resident = cache_control.measure(N, extent_of);
+        std::cout << "Cache state " << CACHE_STATE << " set in " << cache_ms << " ms: " << resident.cached 
+                  << " of " << resident.total << " pages resident ("
+                  << (resident.total > 0 ? 100.0 * resident.cached / resident.total : 0) << "%, " 
+                  << resident.dirty << " dirty, " << resident.method << ")" << std::endl;
+        return true;
+    };
+    if (!set_cache_state()) {
+        return 1;
+    }
+    
+    // One time series spans every measured run from here on
+    if (sampler) sampler->start();
+    
+    // Replay workload: the operations of a recorded trace at their recorded times
+    if (WORKLOAD == "replay") {
+        ReplayResult result;
+        LoopConfig replay_cfg = loop_cfg;
+        if (DURATION > 0) replay_cfg.deadline = deadline_after(DURATION);
+        // Files an earlier replay deleted start out deleted
+        std::vector<char> missing(N + 1, 0);
+        int missing_files = 0;
+        for (int i = 1; i <= N; i++) {
+            missing[i] = access(FILE_LAYOUT.path(i).c_str(), F_OK) != 0;
+            missing_files += missing[i];
+        }
+        if (missing_files > 0) {
+            std::cout << missing_files << " of " << N << " files are missing; the trace's writes recreate them" << std::endl;
+        }
+        IoCounters io_before = io_accounting.snapshot();
+        trace.start();
+        auto start_read = Clock::now();
+        bool ok = replay_loop(replay_cfg, trace, missing, REPLAY_WORKERS, REPLAY_SPEED, reader_pool, start_read, result);
+        if (!ok) {
+            return 1;
+        }
+        double seconds = elapsed_us(start_read, Clock::now()) / 1e6;
+        IoCounters io = io_accounting.snapshot() - io_before;
+        if (sampler) sampler->stop();
+        std::cout << std::endl;
+        std::cout << "Replayed " << trace.records() << " trace operations in " << seconds << " seconds ("
+                  << result.ops[TRACE_READ] << " reads, " << result.ops[TRACE_WRITE] << " writes, "
+                  << result.ops[TRACE_DELETE] << " deletes, " << result.misses << " reads of deleted files)"
+                  << std::endl;
+        std::cout << "Schedule: trace spans " << result.trace_ns / 1e9 << " s; " << result.late
+                  << " operations started more than 1 ms late, max lag " << result.max_lag_ns / 1000.0 << " us"
+                  << std::endl;
+        std::cout << "Reads: " << (result.ops[TRACE_READ] / seconds) << " files/s, "
+                  << (result.bytes_read / seconds / (1024.0 * 1024.0)) << " MB/s; writes: "
+                  << (result.ops[TRACE_WRITE] / seconds) << " files/s, "
+                  << (result.bytes_written / seconds / (1024.0 * 1024.0)) << " MB/s" << std::endl;
+        if (IO_STATS) io_accounting.print(io, result.bytes_read + result.bytes_written, seconds);
+        // The device counters cover every operation; they are reported with the first run
+        const char* labels[] = {"replay_read", "replay_write", "replay_delete"};
+        const char* titles[] = {"Read", "Write", "Delete"};
+        bool first_run = true;
+        for (int op = 0; op < 3; op++) {
+            if (result.ops[op] == 0) continue;
+            print_latency_rows(std::string(titles[op]) + " latency per phase (scheduled: from the intended start)",
+                               result.hist[op].recorded());
+            latency_runs.push_back({REPLAY_WORKERS, result.hist[op], 0, labels[op], seconds, result.ops[op],
+                                    op == TRACE_READ ? result.bytes_read : op == TRACE_WRITE ? result.bytes_written : 0,
+                                    first_run ? io : IoCounters()});
+            first_run = false;
+        }
+        return write_results() ? 0 : 1;
+    }
+    
+    // Mixed workload: concurrent readers and writers
+    if (WORKLOAD == "mixed") {
+        MixedResult result;
+        auto faults_before = page_faults();
+        LoopConfig mixed_cfg = loop_cfg;
+        if (DURATION > 0) mixed_cfg.deadline = deadline_after(DURATION);
+        IoCounters io_before = io_accounting.snapshot();
+        auto start_read = Clock::now();
+        bool ok = mixed_loop(mixed_cfg, selector, RUN_ITER, READERS, WRITERS, RATIO_READS, RATIO_WRITES,
+                             reader_pool, start_read, result);
+        if (!ok) {
+            return 1;
+        }
+        double seconds = elapsed_us(start_read, Clock::now()) / 1e6;
+        IoCounters io = io_accounting.snapshot() - io_before;
+        if (sampler) sampler->stop();
+        std::cout << std::endl;
+        std::cout << "Completed mixed workload in " << seconds << " seconds" << std::endl;
+        std::cout << "Reads: " << result.reads << " (" << (result.reads / seconds) << " files/s, " 
+                  << (result.bytes_read / seconds / (1024.0 * 1024.0)) << " MB/s)" << std::endl;
+        std::cout << "Writes: " << result.writes << " (" << (result.writes / seconds) << " files/s, " 
+                  << (result.bytes_written / seconds / (1024.0 * 1024.0)) << " MB/s)" << std::endl;
+        if (IO_STATS) io_accounting.print(io, result.bytes_read + result.bytes_written, seconds);
+        if (fd_cache) fd_cache->print_stats();
+        if (ENGINE == "mmap") print_page_faults(faults_before, result.reads);
+        if (result.reads > 0) {
+            print_latency_rows("Read latency per phase", result.read_hist.recorded());
+            latency_runs.push_back({READERS, result.read_hist, 0, "mixed_read", seconds, result.reads,
+                                    result.bytes_read, io});
+        }
+        if (result.writes > 0) {
+            print_latency_rows("Write latency per phase", result.write_hist.recorded());
+            // The device counters cover both halves; they are reported with the first
+            latency_runs.push_back({WRITERS, result.write_hist, 0, "mixed_write", seconds, result.writes,
+                                    result.bytes_written, result.reads > 0 ? IoCounters() : io});
+        }
+        return write_results() ? 0 : 1;
+    }
+    
+    // --sweep_chunks/--sweep_depths: run the read phase once per (chunk size,
+    // depth) point. Depth is files in flight on the sync engine, reader pool
+    // threads with PARALLEL_READ, and queue depth (with as many files in
+    // flight) on io_uring.
+    if (SWEEP) {
+        struct SweepPoint {
+            int chunk;
+            int depth;
+            double seconds;
+            long long files;
+            long long bytes;
+        };
+        std::vector<SweepPoint> points;
+        for (int chunk : SWEEP_CHUNKS) {
+            for (int depth : SWEEP_DEPTHS) {
+                LoopConfig point_cfg = loop_cfg;
+                point_cfg.chunk_size = chunk;
+                point_cfg.queue_depth = depth;
+                std::cout << std::endl << "Running " << RUN_LENGTH << " iterations with chunk size " << chunk 
+                          << ", depth " << depth << "..." << std::endl;
+                if (!points.empty() && !set_cache_state()) {
                     return 1;
                 }
-                
-                file_total_read = total_read.load();
-            } else {
-                // Sequential reading
-                size_t file_remaining = aligned_K;
-                while (file_remaining > 0) {
-                    size_t to_read = (file_remaining < CHUNK_SIZE) ? file_remaining : CHUNK_SIZE;
-                    
-                    ssize_t bytes_read = read(fd, read_buffer, to_read);
-                    if (bytes_read < 0) {
-                        std::cerr << "Error reading file " << filename 
-                                  << " (errno: " << errno << ")" << std::endl;
-                        close(fd);
-                        free(read_buffer);
+                std::unique_ptr<ReaderPool> point_pool;
+                if (PARALLEL_READ) {
+                    point_pool = std::make_unique<ReaderPool>();
+                    if (!point_pool->start(depth, buffer_arena, 2 * depth)) {
+                        std::cerr << "Error setting up reader pool buffers" << std::endl;
                         return 1;
                     }
-                    if (bytes_read == 0) {
-                        break;  // EOF
-                    }
-                    
-                    file_total_read += bytes_read;
-                    file_remaining -= bytes_read;
                 }
+                if (DURATION > 0) point_cfg.deadline = deadline_after(DURATION);
+                IoCounters io_before = io_accounting.snapshot();
+                auto start_read = Clock::now();
+                long long total_bytes_read = 0;
+                PhaseHistograms hist;
+                bool ok = (ENGINE == "io_uring")
+                    ? io_uring_read_loop(point_cfg, file_permutation, RUN_ITER, depth, true, start_read,
+                                         total_bytes_read, hist)
+                    : sync_inflight_loop(point_cfg, file_permutation, RUN_ITER, PARALLEL_READ ? 1 : depth,
+                                         point_pool ? *point_pool : reader_pool, start_read,
+                                         total_bytes_read, hist);
+                if (!ok) {
+                    return 1;
+                }
+                double seconds = elapsed_us(start_read, Clock::now()) / 1e6;
+                IoCounters io = io_accounting.snapshot() - io_before;
+                long long files = (long long)hist.file.count();
+                points.push_back({chunk, depth, seconds, files, total_bytes_read});
+                latency_runs.push_back({depth, hist, (size_t)chunk, "sweep", seconds, files, total_bytes_read, io});
+                std::cout << "  chunk=" << chunk << " depth=" << depth << ": " << (files / seconds) 
+                          << " files/s, " << (total_bytes_read / seconds / (1024.0 * 1024.0)) << " MB/s" << std::endl;
+                if (IO_STATS) io_accounting.print(io, total_bytes_read, seconds);
             }
         }
         
-        total_bytes_read += file_total_read;
-        
-        // 3. Close file i
-        close(fd);
+        if (sampler) sampler->stop();
+        std::cout << std::endl;
+        std::cout << "Sweep results (" << RUN_LENGTH << " iterations each):" << std::endl;
+        std::cout << "  chunk  depth  files/s  MB/s  avg_latency_us  p50_latency_us  p99_latency_us" << std::endl;
+        size_t best = 0;
+        for (size_t p = 0; p < points.size(); p++) {
+            const auto& file = latency_runs[p].hist.file;
+            std::cout << "  " << points[p].chunk << "  " << points[p].depth << "  " 
+                      << (points[p].files / points[p].seconds) << "  " 
+                      << (points[p].bytes / points[p].seconds / (1024.0 * 1024.0)) << "  " 
+                      << file.mean_ns() / 1000.0 << "  " << file.percentile_ns(50) / 1000.0 << "  " 
+                      << file.percentile_ns(99) / 1000.0 << std::endl;
+            if (points[p].bytes / points[p].seconds > points[best].bytes / points[best].seconds) best = p;
+        }
+        // Past the knee more depth only adds queueing, so recommend the
+        // shallowest point within 5% of the peak, then the lowest p99
+        double peak = points[best].bytes / points[best].seconds;
+        size_t pick = best;
+        for (size_t p = 0; p < points.size(); p++) {
+            if (points[p].bytes / points[p].seconds < 0.95 * peak) continue;
+            uint64_t p99 = latency_runs[p].hist.file.percentile_ns(99);
+            uint64_t pick_p99 = latency_runs[pick].hist.file.percentile_ns(99);
+            if (points[p].depth < points[pick].depth || (points[p].depth == points[pick].depth && p99 < pick_p99)) {
+                pick = p;
+            }
+        }
+        std::cout << "Peak throughput: chunk " << points[best].chunk << ", depth " << points[best].depth 
+                  << " (" << peak / (1024.0 * 1024.0) << " MB/s)" << std::endl;
+        std::cout << "Recommended: chunk " << points[pick].chunk << ", depth " << points[pick].depth << " (" 
+                  << points[pick].bytes / points[pick].seconds / (1024.0 * 1024.0) << " MB/s, p99 " 
+                  << latency_runs[pick].hist.file.percentile_ns(99) / 1000.0 
+                  << " us; shallowest depth within 5% of the peak)" << std::endl;
+        return write_results() ? 0 : 1;
+    }
+    
+    // --inflight: run the read phase once per requested depth and compare
+    if (!INFLIGHT.empty()) {
+        struct InflightResult {
+            int inflight;
+            double seconds;
+            long long files;
+            long long bytes;
+        };
+        std::vector<InflightResult> results;
+        for (int depth : INFLIGHT) {
+            std::cout << std::endl << "Running " << RUN_LENGTH << " iterations with " << depth 
+                      << " files in flight..." << std::endl;
+            if (!results.empty() && !set_cache_state()) {
+                return 1;
+            }
+            if (fd_cache) fd_cache->reset_stats();
+            auto faults_before = page_faults();
+            LoopConfig depth_cfg = loop_cfg;
+            if (DURATION > 0) depth_cfg.deadline = deadline_after(DURATION);
+            IoCounters io_before = io_accounting.snapshot();
+            auto start_read = Clock::now();
+            long long total_bytes_read = 0;
+            PhaseHistograms hist;
+            bool ok = (ENGINE == "io_uring")
+                ? io_uring_read_loop(depth_cfg, file_permutation, RUN_ITER, depth, true, start_read,
+                                     total_bytes_read, hist)
+                : sync_inflight_loop(depth_cfg, file_permutation, RUN_ITER, depth, reader_pool,
+                                     start_read, total_bytes_read, hist);
+            if (!ok) {
+                return 1;
+            }
+            double seconds = elapsed_us(start_read, Clock::now()) / 1e6;
+            IoCounters io = io_accounting.snapshot() - io_before;
+            long long files = (long long)hist.file.count();
+            results.push_back({depth, seconds, files, total_bytes_read});
+            std::cout << "  inflight=" << depth << ": " << (files / seconds) << " files/s, " 
+                      << (total_bytes_read / seconds / (1024.0 * 1024.0)) << " MB/s " << bytes_label << std::endl;
+            if (IO_STATS) io_accounting.print(io, total_bytes_read, seconds);
+            if (fd_cache) fd_cache->print_stats();
+            if (ENGINE == "mmap") print_page_faults(faults_before, files);
+            print_latency_table(hist);
+            latency_runs.push_back({depth, hist, 0, WORKLOAD, seconds, files, total_bytes_read, io});
+        }
         
-        // Print progress every 1000 iterations
-        if ((i + 1) % 1000 == 0) {
-            auto current_time = std::chrono::high_resolution_clock::now();
-            auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(current_time - start_read);
-            double avg_time = elapsed_ms.count() / (double)(i + 1);
-            std::cout << "  Completed " << (i + 1) << " iterations, avg time per iteration: " 
-                      << avg_time << " ms" << std::endl;
+        if (sampler) sampler->stop();
+        std::cout << std::endl;
+        std::cout << "Throughput and latency by files in flight (" << RUN_LENGTH << " iterations each):" << std::endl;
+        std::cout << "  inflight  files/s  MB/s  avg_latency_us  p99_latency_us  max_latency_us" << std::endl;
+        for (size_t r = 0; r < results.size(); r++) {
+            const auto& file = latency_runs[r].hist.file;
+            std::cout << "  " << results[r].inflight << "  " << (results[r].files / results[r].seconds) << "  " 
+                      << (results[r].bytes / results[r].seconds / (1024.0 * 1024.0)) << "  " 
+                      << file.mean_ns() / 1000.0 << "  " << file.percentile_ns(99) / 1000.0 << "  " 
+                      << file.max_ns() / 1000.0 << std::endl;
         }
+        return write_results() ? 0 : 1;
     }
     
-    // Free aligned buffer
-    free(read_buffer);
+    // Totals cover the runs only, not the --cache_state passes between them
+    auto faults_before = page_faults();
+    long long total_bytes_read = 0;
+    PhaseHistograms hist;
+    std::vector<ShardResult> shard_results;  // Of the last run
+    std::vector<double> run_files_per_sec, run_mb_per_sec, run_p99_us;
+    Clock::duration total_read_time{0};
+    IoCounters io;
     
-    auto end_read = std::chrono::high_resolution_clock::now();
-    auto duration_read_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_read - start_read);
-    auto duration_read_sec = std::chrono::duration_cast<std::chrono::seconds>(end_read - start_read);
+    for (int r = 0; r < REPEAT; r++) {
+        if (REPEAT > 1) std::cout << std::endl << "Run " << r + 1 << " of " << REPEAT << "..." << std::endl;
+        if (r > 0 && !set_cache_state()) {
+            return 1;
+        }
+        LoopConfig run_cfg = loop_cfg;
+        if (DURATION > 0) run_cfg.deadline = deadline_after(DURATION);
+        IoCounters io_before_run = io_accounting.snapshot();
+        auto start_run = Clock::now();
+        long long run_bytes = 0;
+        PhaseHistograms run_hist;
+        shard_results.clear();
+        if (!run_plain(run_cfg, RUN_ITER, start_run, run_bytes, run_hist, shard_results)) {
+            return 1;
+        }
+        auto end_run = Clock::now();
+        IoCounters io_run = io_accounting.snapshot() - io_before_run;
+        double seconds = elapsed_us(start_run, end_run) / 1e6;
+        total_read_time += end_run - start_run;
+        if (r == 0) {
+            io = io_run;
+        } else {
+            io += io_run;
+        }
+        long long files = (long long)run_hist.file.count();
+        run_files_per_sec.push_back(files / seconds);
+        run_mb_per_sec.push_back(run_bytes / seconds / (1024.0 * 1024.0));
+        run_p99_us.push_back(run_hist.file.percentile_ns(99) / 1000.0);
+        if (REPEAT > 1) {
+            std::cout << "  run " << r + 1 << ": " << run_files_per_sec.back() << " files/s, " 
+                      << run_mb_per_sec.back() << " MB/s, p99 " << run_p99_us.back() << " us" << std::endl;
+        }
+        latency_runs.push_back({THREADS > 1 ? THREADS : BATCH_FILES, run_hist, 0, WORKLOAD, seconds, files,
+                                run_bytes, io_run});
+        total_bytes_read += run_bytes;
+        hist.merge(run_hist);
+    }
+    if (sampler) sampler->stop();
+    long long files_done = (long long)hist.file.count();
+    auto duration_read_ms = std::chrono::duration_cast<std::chrono::milliseconds>(total_read_time);
+    auto duration_read_sec = std::chrono::duration_cast<std::chrono::seconds>(total_read_time);
     
     std::cout << std::endl;
-    std::cout << "Completed " << ITER << " iterations" << std::endl;
+    std::cout << "Completed " << files_done << " iterations" << (REPEAT > 1 ? " in " + std::to_string(REPEAT) + " runs" : "") << std::endl;
     std::cout << "Total time: " << duration_read_sec.count() << " seconds (" 
               << duration_read_ms.count() << " ms)" << std::endl;
-    std::cout << "Total bytes read: " << total_bytes_read << std::endl;
+    std::cout << "Total bytes " << bytes_label << ": " << total_bytes_read << std::endl;
     std::cout << "Average time per iteration: " 
-              << (duration_read_ms.count() / (double)ITER) << " ms" << std::endl;
+              << (duration_read_ms.count() / (double)std::max(files_done, 1LL)) << " ms" << std::endl;
+    if (REPEAT > 1) {
+        std::cout << "Across " << REPEAT << " runs:" << std::endl;
+        print_repeat_stats("files/s", run_files_per_sec);
+        print_repeat_stats("MB/s", run_mb_per_sec);
+        print_repeat_stats("p99 latency (us)", run_p99_us);
+    }
+    if (IO_STATS) io_accounting.print(io, total_bytes_read, std::chrono::duration<double>(total_read_time).count());
+    if (WORKLOAD == "write") {
+        // Bytes this process sent to the block layer, including any filesystem overhead it caused
+        long long storage_write_bytes = io.proc_write_bytes;
+        std::cout << "Storage write bytes (/proc/self/io): " << storage_write_bytes;
+        if (total_bytes_read > 0) {
+            std::cout << " (amplification " << (storage_write_bytes / (double)total_bytes_read) << "x)";
+        }
+        std::cout << std::endl;
+    }
+    if (fd_cache) fd_cache->print_stats();
+    if (ENGINE == "mmap") print_page_faults(faults_before, files_done);
+    print_latency_table(hist);
+    if (!shard_results.empty()) {
+        const LatencyRun& last = latency_runs.back();
+        std::cout << "Per-thread throughput (" << THREADS << " threads, aggregate " << (last.ops / last.seconds) 
+                  << " files/s, " << (last.bytes / last.seconds / (1024.0 * 1024.0)) << " MB/s" 
+                  << (REPEAT > 1 ? ", last run" : "") << "):" << std::endl;
+        std::cout << "  thread  cpus  files  files/s  MB/s  avg_latency_us  p99_latency_us" << std::endl;
+        for (size_t t = 0; t < shard_results.size(); t++) {
+            const ShardResult& result = shard_results[t];
+            double thread_seconds = result.seconds > 0 ? result.seconds : 1e-9;
+            std::cout << "  " << t << "  " << (result.cpus.empty() ? "-" : format_cpu_list(result.cpus)) 
+                      << "  " << result.files << "  " << (result.files / thread_seconds) << "  " 
+                      << (result.bytes / thread_seconds / (1024.0 * 1024.0)) << "  " 
+                      << result.hist.file.mean_ns() / 1000.0 << "  " 
+                      << result.hist.file.percentile_ns(99) / 1000.0 << std::endl;
+        }
+    }
     
-    return 0;
+    return write_results() ? 0 : 1;
 }
-
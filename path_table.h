@@ -0,0 +1,172 @@
+#pragma once
+
+// Prebuilt names of the file set for the read loops. Every name is built once
+// into one contiguous table and opened relative to an already open directory
+// with openat() (or openat2() with RESOLVE_* flags), so a measured open costs
+// the filesystem's lookup of one component instead of a heap-allocated full
+// path that the kernel resolves from the root. With a sharded layout of at
+// most max_dir_fds leaf directories every leaf is opened and names are bare
+// "f<i>"; above that names are relative to the base directory.
+
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if __has_include(<linux/openat2.h>)
+#include <linux/openat2.h>
+#define PATH_TABLE_HAVE_OPENAT2 1
+#endif
+
+#include "file_layout.h"
+
+class PathTable {
+public:
+    PathTable() = default;
+    PathTable(const PathTable&) = delete;
+    PathTable& operator=(const PathTable&) = delete;
+    ~PathTable() {
+        for (int fd : dir_fds) close(fd);
+    }
+
+    // Builds names for files 1..num_files and opens their directories.
+    // `resolve` is a comma-separated list of beneath, in_root, no_symlinks,
+    // no_magiclinks, no_xdev and cached (openat2 RESOLVE_* flags). Returns
+    // false on error.
+    bool init(const FileLayout& layout, int num_files, bool noatime, const std::string& resolve,
+              int max_dir_fds) {
+        if (!parse_resolve(resolve)) return false;
+        extra_flags = noatime ? O_NOATIME : 0;
+        bool leaf_fds = layout.sharded() && layout.num_directories() <= max_dir_fds;
+
+        std::unordered_map<std::string, uint32_t> dir_ids;
+        auto dir_id = [&](const std::string& dir) -> int {
+            auto it = dir_ids.find(dir);
+            if (it != dir_ids.end()) return (int)it->second;
+            std::string full = dir.empty() ? layout.base : layout.base + "/" + dir;
+            int fd = ::open(full.c_str(), O_RDONLY | O_DIRECTORY);
+            if (fd == -1) {
+                std::cerr << "Error opening directory " << full << " (errno: " << errno << ")" << std::endl;
+                return -1;
+            }
+            dir_fds.push_back(fd);
+            dir_paths.push_back(full);
+            dir_ids[dir] = (uint32_t)(dir_fds.size() - 1);
+            return (int)dir_fds.size() - 1;
+        };
+
+        offsets.assign(num_files + 1, 0);
+        dir_index.assign(num_files + 1, 0);
+        for (int i = 1; i <= num_files; i++) {
+            std::string shard = layout.shard(i);
+            std::string name = "f" + std::to_string(i);
+            int dir = dir_id(leaf_fds ? shard : "");
+            if (dir < 0) return false;
+            if (!leaf_fds && !shard.empty()) name = shard + "/" + name;
+            offsets[i] = (uint32_t)names.size();
+            dir_index[i] = (uint32_t)dir;
+            names.insert(names.end(), name.begin(), name.end());
+            names.push_back('\0');
+        }
+        if (num_files > 0) probe();
+        return true;
+    }
+
+    // Opens file `file_num` with `flags` (plus O_NOATIME when enabled), or -1 with errno set
+    int open(int file_num, int flags) const {
+        int dir = dir_fds[dir_index[file_num]];
+        const char* name = &names[offsets[file_num]];
+#ifdef PATH_TABLE_HAVE_OPENAT2
+        if (resolve_flags != 0) {
+            struct open_how how;
+            memset(&how, 0, sizeof(how));
+            how.flags = (uint64_t)(flags | extra_flags);
+            how.resolve = resolve_flags;
+            int fd = (int)syscall(SYS_openat2, dir, name, &how, sizeof(how));
+            if (fd == -1 && errno == EAGAIN && (resolve_flags & RESOLVE_CACHED)) {
+                // Not in the dentry cache: RESOLVE_CACHED asks for a retry without it
+                how.resolve = resolve_flags & ~(uint64_t)RESOLVE_CACHED;
+                fd = (int)syscall(SYS_openat2, dir, name, &how, sizeof(how));
+            }
+            return fd;
+        }
+#endif
+        return openat(dir, name, flags | extra_flags);
+    }
+
+    // Full path of file `file_num`, for messages
+    std::string path(int file_num) const {
+        return dir_paths[dir_index[file_num]] + "/" + &names[offsets[file_num]];
+    }
+
+    size_t dir_count() const { return dir_fds.size(); }
+    size_t bytes() const { return names.size() + offsets.size() * sizeof(uint32_t) * 2; }
+    bool uses_openat2() const { return resolve_flags != 0; }
+    bool uses_noatime() const { return extra_flags != 0; }
+
+private:
+    bool parse_resolve(const std::string& list) {
+        size_t start = 0;
+        while (start < list.size()) {
+            size_t comma = list.find(',', start);
+            if (comma == std::string::npos) comma = list.size();
+            std::string flag = list.substr(start, comma - start);
+            start = comma + 1;
+#ifdef PATH_TABLE_HAVE_OPENAT2
+            if (flag == "beneath") { resolve_flags |= RESOLVE_BENEATH; continue; }
+            if (flag == "in_root") { resolve_flags |= RESOLVE_IN_ROOT; continue; }
+            if (flag == "no_symlinks") { resolve_flags |= RESOLVE_NO_SYMLINKS; continue; }
+            if (flag == "no_magiclinks") { resolve_flags |= RESOLVE_NO_MAGICLINKS; continue; }
+            if (flag == "no_xdev") { resolve_flags |= RESOLVE_NO_XDEV; continue; }
+#ifdef RESOLVE_CACHED
+            if (flag == "cached") { resolve_flags |= RESOLVE_CACHED; continue; }
+#endif
+            std::cerr << "Unknown --resolve flag: " << flag << std::endl;
+#else
+            std::cerr << "--resolve needs openat2(), which this build does not have: " << flag << std::endl;
+#endif
+            return false;
+        }
+        return true;
+    }
+
+    // Drops what the kernel or the file ownership does not allow, once, so the
+    // measured loop never takes an error path for it
+    void probe() {
+#ifdef PATH_TABLE_HAVE_OPENAT2
+        if (resolve_flags != 0) {
+            int fd = open(1, O_RDONLY);
+            if (fd == -1 && errno == ENOSYS) {
+                std::cout << "Warning: openat2() not supported, opening with openat() without --resolve" << std::endl;
+                resolve_flags = 0;
+            } else if (fd != -1) {
+                close(fd);
+            }
+        }
+#endif
+        if (extra_flags & O_NOATIME) {
+            int fd = open(1, O_RDONLY);
+            if (fd == -1 && errno == EPERM) {
+                std::cout << "Warning: O_NOATIME not permitted (files owned by another user), opening without it"
+                          << std::endl;
+                extra_flags &= ~O_NOATIME;
+            } else if (fd != -1) {
+                close(fd);
+            }
+        }
+    }
+
+    std::vector<char> names;         // NUL-terminated names, back to back
+    std::vector<uint32_t> offsets;   // file_num -> start of its name in `names`
+    std::vector<uint32_t> dir_index; // file_num -> entry of dir_fds
+    std::vector<int> dir_fds;
+    std::vector<std::string> dir_paths;
+    int extra_flags = 0;
+    uint64_t resolve_flags = 0;
+};
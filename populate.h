@@ -0,0 +1,201 @@
+#pragma once
+
+// In-process creation of the benchmark file set. Replaces one `dd` process per
+// file: a few threads each reuse one aligned buffer, refill it from a fast PRNG
+// (or leave it zero / patterned) and pwrite() it, optionally after fallocate().
+// populate_slab() fills the slots of a single slab file or block device instead.
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "verify.h"
+
+struct PopulateConfig {
+    int num_files;
+    long long file_size;
+    int threads;
+    std::string fill;        // "random", "zero" or "pattern"
+    bool write_data;         // false: create empty files (SKIP_WRITE)
+    bool preallocate;        // fallocate() the full size before writing
+    bool o_direct;           // Write with O_DIRECT
+    bool stamp;              // --verify: stamp every block as generation 0 of its entry
+};
+
+// splitmix64: fast, statistically decent, and a distinct stream per seed
+static inline uint64_t populate_next_random(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static inline void populate_fill_buffer(char* buffer, size_t size, const std::string& fill,
+                                        uint64_t& rng_state) {
+    if (fill == "random") {
+        uint64_t* words = reinterpret_cast<uint64_t*>(buffer);
+        for (size_t i = 0; i < size / sizeof(uint64_t); i++) {
+            words[i] = populate_next_random(rng_state);
+        }
+    }
+}
+
+// Runs `write_item(i, buffer, buffer_size, rng_state)` for i = 1..num_files on
+// cfg.threads threads, each with its own aligned buffer (pattern or zero
+// prefilled) and PRNG stream. Prints progress every 1000 items. Returns false
+// on the first failed item.
+static inline bool populate_parallel(
+        const PopulateConfig& cfg,
+        const std::function<bool(int, char*, size_t, uint64_t&)>& write_item) {
+    const size_t ALIGNMENT = 4096;
+    const size_t MAX_BUFFER = 4 * 1024 * 1024;
+    size_t buffer_size = (size_t)cfg.file_size < MAX_BUFFER ? (size_t)cfg.file_size : MAX_BUFFER;
+    buffer_size = (buffer_size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    if (buffer_size == 0) buffer_size = ALIGNMENT;
+    int threads = cfg.threads > 0 ? cfg.threads : 1;
+
+    std::atomic<int> next_file(1);
+    std::atomic<int> created(0);
+    std::atomic<bool> error_occurred(false);
+    std::mutex progress_mutex;
+    auto start_create = std::chrono::high_resolution_clock::now();
+
+    auto worker = [&](int t) {
+        void* raw;
+        if (posix_memalign(&raw, ALIGNMENT, buffer_size) != 0) {
+            std::cerr << "Error allocating populate buffer" << std::endl;
+            error_occurred = true;
+            return;
+        }
+        char* buffer = static_cast<char*>(raw);
+        if (cfg.fill == "pattern") {
+            for (size_t i = 0; i < buffer_size; i++) buffer[i] = (char)(i * 31 + 7);
+        } else {
+            memset(buffer, 0, buffer_size);
+        }
+        uint64_t rng_state = ((uint64_t)t + 1) * 0x2545F4914F6CDD1Dull ^
+                             (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+
+        int i;
+        while (!error_occurred && (i = next_file++) <= cfg.num_files) {
+            if (!write_item(i, buffer, buffer_size, rng_state)) {
+                error_occurred = true;
+                break;
+            }
+
+            // Print progress every 1000 files
+            int done = ++created;
+            if (done % 1000 == 0) {
+                auto current_time = std::chrono::high_resolution_clock::now();
+                auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(current_time - start_create);
+                double avg_time = elapsed_ms.count() / (double)done;
+                std::lock_guard<std::mutex> lock(progress_mutex);
+                std::cout << "  Created " << done << " files, avg time per file: "
+                          << avg_time << " ms" << std::endl;
+            }
+        }
+        free(buffer);
+    };
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back(worker, t);
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    return !error_occurred;
+}
+
+// Writes cfg.file_size bytes of fill data for entry `file_num` at `base` in `fd`
+static inline bool populate_write_range(const PopulateConfig& cfg, int fd, off_t base, int file_num,
+                                        char* buffer, size_t buffer_size, uint64_t& rng_state,
+                                        const std::string& filename) {
+    long long offset = 0;
+    while (offset < cfg.file_size) {
+        size_t to_write = (size_t)std::min<long long>(buffer_size, cfg.file_size - offset);
+        populate_fill_buffer(buffer, to_write, cfg.fill, rng_state);
+        if (cfg.stamp) Verifier::stamp(buffer, to_write, offset, file_num, 0);
+        ssize_t written = pwrite(fd, buffer, to_write, base + offset);
+        if (written <= 0) {
+            std::cerr << "Error writing file: " << filename << " (errno: " << errno << ")" << std::endl;
+            return false;
+        }
+        offset += written;
+    }
+    return true;
+}
+
+// Creates files 1..num_files, named by `file_name`. Prints progress every 1000
+// files. Returns false on the first error.
+static inline bool populate_files(const PopulateConfig& cfg,
+                                  const std::function<std::string(int)>& file_name) {
+    return populate_parallel(cfg, [&](int i, char* buffer, size_t buffer_size, uint64_t& rng_state) {
+        std::string filename = file_name(i);
+        int flags = O_WRONLY | O_CREAT | O_TRUNC | (cfg.o_direct && cfg.write_data ? O_DIRECT : 0);
+        int fd = open(filename.c_str(), flags, 0644);
+        if (fd == -1) {
+            std::cerr << "Error creating file: " << filename << " (errno: " << errno << ")" << std::endl;
+            return false;
+        }
+        if (cfg.write_data) {
+            if (cfg.preallocate && cfg.file_size > 0 && fallocate(fd, 0, 0, cfg.file_size) != 0) {
+                std::cerr << "Error preallocating file: " << filename << " (errno: " << errno << ")" << std::endl;
+                close(fd);
+                return false;
+            }
+            if (!populate_write_range(cfg, fd, 0, i, buffer, buffer_size, rng_state, filename)) {
+                close(fd);
+                return false;
+            }
+        }
+        close(fd);
+        return true;
+    });
+}
+
+// Fills slots 1..num_files of the slab at `path`, slot i at (i - 1) * slot_size.
+// A regular file is created (truncated) and sized to hold every slot, or
+// fallocate()d with cfg.preallocate; a block device is written in place.
+// Returns false on the first error.
+static inline bool populate_slab(const PopulateConfig& cfg, const std::string& path, long long slot_size) {
+    int flags = O_RDWR | O_CREAT | (cfg.o_direct ? O_DIRECT : 0);
+    int fd = open(path.c_str(), flags, 0644);
+    if (fd == -1) {
+        std::cerr << "Error creating slab: " << path << " (errno: " << errno << ")" << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        std::cerr << "Error in fstat of slab: " << path << " (errno: " << errno << ")" << std::endl;
+        close(fd);
+        return false;
+    }
+    if (S_ISREG(st.st_mode)) {
+        long long slab_size = (long long)cfg.num_files * slot_size;
+        bool sized = (ftruncate(fd, 0) == 0) &&
+                     (cfg.preallocate ? fallocate(fd, 0, 0, slab_size) == 0 : ftruncate(fd, slab_size) == 0);
+        if (!sized) {
+            std::cerr << "Error sizing slab: " << path << " (errno: " << errno << ")" << std::endl;
+            close(fd);
+            return false;
+        }
+    }
+    bool ok = !cfg.write_data || populate_parallel(cfg, [&](int i, char* buffer, size_t buffer_size, uint64_t& rng_state) {
+        return populate_write_range(cfg, fd, (off_t)(i - 1) * slot_size, i, buffer, buffer_size, rng_state, path);
+    });
+    close(fd);
+    return ok;
+}
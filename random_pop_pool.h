@@ -0,0 +1,255 @@
+#pragma once
+
+// Pools of file ids supporting "exclusive checkout of a random file": pop()
+// removes a random id so no other thread can get it until add() returns it.
+//   LockedRandomPopPool   EfficientRandomPopContainer behind one mutex, as in file_manager.py
+//   ShardedRandomPopPool  per-thread shards with work stealing, scales with cores
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Per-thread generator for random file / slot selection
+static inline std::mt19937_64& manager_rng() {
+    static thread_local std::mt19937_64 rng(std::random_device{}());
+    return rng;
+}
+
+// Cheap per-thread xorshift for hot-path index picks
+static inline uint64_t fast_random() {
+    static thread_local uint64_t state = manager_rng()() | 1;
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+// Port of EfficientRandomPopContainer: O(1) add and pop of a random element
+class EfficientRandomPopContainer {
+public:
+    explicit EfficientRandomPopContainer(int max_elements) : elements(max_elements) {}
+
+    void add_element(int element) {
+        elements[curr_elements++] = element;
+    }
+
+    int pop_random_element() {
+        std::uniform_int_distribution<int> dist(0, curr_elements - 1);
+        int random_idx = dist(manager_rng());
+        int element = elements[random_idx];
+        elements[random_idx] = elements[curr_elements - 1];
+        curr_elements--;
+        return element;
+    }
+
+    int size() const { return curr_elements; }
+
+private:
+    std::vector<int> elements;
+    int curr_elements = 0;
+};
+
+class RandomPopPool {
+public:
+    virtual ~RandomPopPool() = default;
+    // Removes and returns a random id; waits while the pool is empty
+    virtual int pop() = 0;
+    virtual void add(int id) = 0;
+    virtual int size() const = 0;
+};
+
+class LockedRandomPopPool : public RandomPopPool {
+public:
+    explicit LockedRandomPopPool(int max_elements) : files(max_elements) {}
+
+    int pop() override {
+        std::unique_lock<std::mutex> lock(files_lock);
+        file_available.wait(lock, [this] { return files.size() > 0; });
+        return files.pop_random_element();
+    }
+
+    void add(int id) override {
+        {
+            std::lock_guard<std::mutex> lock(files_lock);
+            files.add_element(id);
+        }
+        file_available.notify_one();
+    }
+
+    int size() const override {
+        std::lock_guard<std::mutex> lock(files_lock);
+        return files.size();
+    }
+
+private:
+    EfficientRandomPopContainer files;
+    mutable std::mutex files_lock;
+    std::condition_variable file_available;
+};
+
+// Ids are spread over one shard per hardware thread, each a small locked
+// EfficientRandomPopContainer. add() puts an id into the smaller of two random
+// shards and pop() swap-pops a random id of a random shard, moving on to the
+// next shard when that one is empty. Where an id goes does not depend on the
+// thread returning it, and the two-choice placement keeps the shards within a
+// few ids of each other, so every free id is about equally likely to be
+// checked out next. There is no shared counter on the hot path; a pop that finds
+// every shard empty sleeps on `available` until an add() sees it waiting.
+class ShardedRandomPopPool : public RandomPopPool {
+public:
+    explicit ShardedRandomPopPool(int max_elements, int num_shards = 0)
+        : shard_count(shard_count_for(max_elements, num_shards)),
+          shards(new Shard[shard_count]) {}
+
+    int pop() override {
+        int id;
+        if (pop_any(id)) {
+            return id;
+        }
+        std::unique_lock<std::mutex> lock(wait_lock);
+        waiters.fetch_add(1);
+        while (!pop_any(id)) {
+            available.wait(lock);
+        }
+        waiters.fetch_sub(1);
+        return id;
+    }
+
+    void add(int id) override {
+        Shard& first = shards[fast_random() % shard_count];
+        Shard& second = shards[fast_random() % shard_count];
+        Shard& shard = (second.count.load(std::memory_order_relaxed) < first.count.load(std::memory_order_relaxed))
+                     ? second : first;
+        {
+            std::lock_guard<std::mutex> lock(shard.lock);
+            shard.ids.push_back(id);
+            shard.count.store((int)shard.ids.size(), std::memory_order_relaxed);
+        }
+        // Pairs with the waiter count taken in pop(): either the sleeper's
+        // scan sees this id, or this sees the sleeper
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(wait_lock);
+            available.notify_one();
+        }
+    }
+
+    int size() const override {
+        size_t total = 0;
+        for (size_t s = 0; s < shard_count; s++) {
+            std::lock_guard<std::mutex> lock(shards[s].lock);
+            total += shards[s].ids.size();
+        }
+        return (int)total;
+    }
+
+private:
+    struct alignas(64) Shard {
+        mutable std::mutex lock;
+        std::vector<int> ids;
+        std::atomic<int> count{0};   // ids.size(), readable without the lock
+    };
+
+    static size_t shard_count_for(int max_elements, int num_shards) {
+        if (num_shards <= 0) num_shards = (int)std::max(1u, std::thread::hardware_concurrency());
+        return (size_t)std::max(1, std::min(num_shards, std::max(max_elements, 1)));
+    }
+
+    bool try_pop(size_t s, int& id) {
+        Shard& shard = shards[s];
+        std::lock_guard<std::mutex> lock(shard.lock);
+        size_t count = shard.ids.size();
+        if (count == 0) return false;
+        size_t idx = fast_random() % count;
+        id = shard.ids[idx];
+        shard.ids[idx] = shard.ids[count - 1];
+        shard.ids.pop_back();
+        shard.count.store((int)count - 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Tries every shard, from a random one onwards
+    bool pop_any(int& id) {
+        size_t start = fast_random() % shard_count;
+        for (size_t i = 0; i < shard_count; i++) {
+            if (try_pop((start + i) % shard_count, id)) return true;
+        }
+        return false;
+    }
+
+    const size_t shard_count;
+    std::unique_ptr<Shard[]> shards;
+    alignas(64) std::atomic<int> waiters{0};
+    std::mutex wait_lock;
+    std::condition_variable available;
+};
+
+// Outcome of random_pop_pool_churn
+struct PoolChurn {
+    double ops_per_sec = 0;        // Pop/add pairs per second over all threads
+    int distinct = 0;              // Ids checked out at least once
+    int min_thread_distinct = 0;   // Fewest distinct ids any one thread checked out
+    double max_per_mean = 0;       // Checkouts of the most popular id over the mean
+};
+
+// Pop/add churn on `pool` holding ids 0..num_ids-1, at least `threads` of
+// them: each thread checks out a random id and returns it, `ops_per_thread`
+// times, counting what it was handed so the spread over the ids can be
+// compared between pools.
+static inline PoolChurn random_pop_pool_churn(RandomPopPool& pool, int num_ids, int threads, long long ops_per_thread) {
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::vector<uint32_t>> checkouts(threads, std::vector<uint32_t>(num_ids, 0));
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            std::vector<uint32_t>& mine = checkouts[t];
+            ready++;
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            for (long long i = 0; i < ops_per_thread; i++) {
+                int id = pool.pop();
+                mine[id]++;
+                pool.add(id);
+            }
+        });
+    }
+    while (ready.load() < threads) std::this_thread::yield();
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& worker : workers) worker.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    PoolChurn churn;
+    churn.ops_per_sec = threads * (double)ops_per_thread / (seconds > 0 ? seconds : 1e-9);
+    churn.min_thread_distinct = num_ids;
+    std::vector<uint64_t> total(num_ids, 0);
+    for (const auto& mine : checkouts) {
+        int distinct = 0;
+        for (int id = 0; id < num_ids; id++) {
+            distinct += mine[id] > 0;
+            total[id] += mine[id];
+        }
+        churn.min_thread_distinct = std::min(churn.min_thread_distinct, distinct);
+    }
+    uint64_t most = 0;
+    for (int id = 0; id < num_ids; id++) {
+        churn.distinct += total[id] > 0;
+        most = std::max(most, total[id]);
+    }
+    double mean = threads * (double)ops_per_thread / std::max(num_ids, 1);
+    churn.max_per_mean = mean > 0 ? most / mean : 0;
+    return churn;
+}
+
+// `sharded` selects ShardedRandomPopPool, otherwise LockedRandomPopPool
+static inline std::unique_ptr<RandomPopPool> make_random_pop_pool(bool sharded, int max_elements) {
+    if (sharded) return std::make_unique<ShardedRandomPopPool>(max_elements);
+    return std::make_unique<LockedRandomPopPool>(max_elements);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+// Token-bucket throttling, the native replacement for RateLimiter in
+// file_manager.py. The Python limiter hands out a whole second of budget at
+// the start of each wall-clock second, so throttled traffic arrives as bursts.
+// Here tokens are credited every `granularity` (e.g. 1 ms) instead, with at
+// most one granularity worth of burst, which produces smooth load.
+//
+// The bucket is kept as a GCRA "theoretical arrival time": one atomic holding
+// the time at which the budget would be exhausted. A caller reserves its bytes
+// with a single CAS and then sleeps until its reservation is due, so the fast
+// path (budget available) takes no lock.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+class TokenBucket {
+public:
+    TokenBucket(double bytes_per_second, uint64_t granularity_ns)
+        : ns_per_byte(1e9 / bytes_per_second),
+          granularity(granularity_ns > 0 ? granularity_ns : 1),
+          burst_ns(granularity_ns > 0 ? granularity_ns : 1),
+          tat(0) {}
+
+    // Blocks until `bytes` fit in the budget
+    void acquire(uint64_t bytes) {
+        int64_t cost = (int64_t)(bytes * ns_per_byte);
+        int64_t now = quantized_now();
+        int64_t old_tat = tat.load(std::memory_order_relaxed);
+        int64_t new_tat;
+        do {
+            // An idle bucket does not bank budget beyond the burst allowance
+            int64_t base = (old_tat > now) ? old_tat : now;
+            new_tat = base + cost;
+        } while (!tat.compare_exchange_weak(old_tat, new_tat, std::memory_order_relaxed));
+
+        // Up to one granularity of reservations may run ahead of the clock
+        int64_t wait_ns = new_tat - burst_ns - now;
+        if (wait_ns > 0) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(wait_ns));
+        }
+    }
+
+    double rate() const { return 1e9 / ns_per_byte; }
+
+private:
+    // Time only advances in whole granularity steps, so tokens are credited per step
+    int64_t quantized_now() const {
+        int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        return now - now % (int64_t)granularity;
+    }
+
+    const double ns_per_byte;
+    const uint64_t granularity;
+    const int64_t burst_ns;
+    std::atomic<int64_t> tat;
+};
+
+// Read and write budgets. With a single shared rate both directions draw from
+// one bucket, like the Python RateLimiter; otherwise each has its own.
+class RateLimiter {
+public:
+    // A rate of 0 leaves that direction unthrottled
+    RateLimiter(double shared_rate, double read_rate, double write_rate, uint64_t granularity_ns) {
+        if (shared_rate > 0) {
+            read_bucket = std::make_shared<TokenBucket>(shared_rate, granularity_ns);
+            write_bucket = read_bucket;
+        }
+        if (read_rate > 0) read_bucket = std::make_shared<TokenBucket>(read_rate, granularity_ns);
+        if (write_rate > 0) write_bucket = std::make_shared<TokenBucket>(write_rate, granularity_ns);
+    }
+
+    void wait_for_allowance(uint64_t bytes_to_allow, bool is_read) {
+        TokenBucket* bucket = is_read ? read_bucket.get() : write_bucket.get();
+        if (bucket) {
+            bucket->acquire(bytes_to_allow);
+        }
+    }
+
+    bool enabled() const { return read_bucket || write_bucket; }
+
+private:
+    std::shared_ptr<TokenBucket> read_bucket;
+    std::shared_ptr<TokenBucket> write_bucket;
+};
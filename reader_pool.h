@@ -0,0 +1,150 @@
+#pragma once
+
+// Fixed-size pool of reader threads used by PARALLEL_READ. Workers are created
+// once and each owns a preallocated aligned buffer, so the measured loop only
+// pays for queueing and pread(), not for clone() and the allocator.
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "buffer_arena.h"
+
+// Tracks the chunk reads issued for one file so the caller can wait for them
+class ReadBatch {
+public:
+    std::atomic<long long> bytes_read{0};
+    std::atomic<bool> error{false};
+
+    void add(int count) {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending += count;
+    }
+
+    void done() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pending == 0) {
+            cv.notify_all();
+        }
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return pending == 0; });
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    int pending = 0;
+};
+
+struct ReadTask {
+    int fd;
+    off_t offset;
+    size_t len;
+    ReadBatch* batch;
+};
+
+class ReaderPool {
+public:
+    ReaderPool() = default;
+    ReaderPool(const ReaderPool&) = delete;
+    ReaderPool& operator=(const ReaderPool&) = delete;
+    ~ReaderPool() { stop(); }
+
+    // Starts the workers, each with a buffer borrowed from `arena` for the
+    // pool's lifetime. At most `queue_capacity` tasks wait in the queue;
+    // submit() blocks beyond that. Returns false if the arena runs out.
+    bool start(int num_threads, BufferArena& arena, size_t queue_capacity) {
+        queue.resize(queue_capacity);
+        buffer_arena = &arena;
+        for (int t = 0; t < num_threads; t++) {
+            char* buffer = arena.acquire();
+            if (!buffer) {
+                stop();
+                return false;
+            }
+            buffers.push_back(buffer);
+        }
+        start_workers();
+        return true;
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        not_empty.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+        for (char* buffer : buffers) {
+            buffer_arena->release(buffer);
+        }
+        buffers.clear();
+        buffer_arena = nullptr;
+    }
+
+    int size() const { return (int)buffers.size(); }
+
+    // Queues one chunk read; the caller must have done task.batch->add() for it
+    void submit(const ReadTask& task) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [this] { return count < queue.size(); });
+        queue[(head + count) % queue.size()] = task;
+        count++;
+        lock.unlock();
+        not_empty.notify_one();
+    }
+
+private:
+    void start_workers() {
+        for (int t = 0; t < (int)buffers.size(); t++) {
+            workers.emplace_back([this, t]() { worker_loop(buffers[t]); });
+        }
+    }
+
+    void worker_loop(char* buffer) {
+        while (true) {
+            ReadTask task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                not_empty.wait(lock, [this] { return count > 0 || stopping; });
+                if (count == 0) {
+                    return;
+                }
+                task = queue[head];
+                head = (head + 1) % queue.size();
+                count--;
+            }
+            not_full.notify_one();
+
+            ssize_t bytes_read = pread(task.fd, buffer, task.len, task.offset);
+            if (bytes_read != (ssize_t)task.len) {
+                task.batch->error = true;
+            } else {
+                task.batch->bytes_read += bytes_read;
+            }
+            task.batch->done();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::vector<char*> buffers;
+    BufferArena* buffer_arena = nullptr;  // Owner of `buffers`
+
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::vector<ReadTask> queue;
+    size_t head = 0;
+    size_t count = 0;
+    bool stopping = false;
+};
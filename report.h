@@ -0,0 +1,346 @@
+#pragma once
+
+// Machine-readable results for --output=json|csv. A report holds every
+// parameter, the setup phase timings, the host environment and one record per
+// measured run, so regression tracking does not depend on the wording of the
+// human-readable output. One "op" is one file (or slot) access, so iops is
+// files per second.
+//
+// JSON: {"parameters": {...}, "environment": {...}, "timings_ms": {...}, "runs": [...]}
+// CSV:  a header and one row per run; parameter and environment columns are
+//       prefixed with param_ and env_ and repeated on every row.
+
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#include <sys/types.h>
+#include <sys/sysmacros.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "io_accounting.h"
+#include "latency_histogram.h"
+
+// One measured run
+struct LatencyRun {
+    int inflight;             // Files (or I/Os, for sweep points) in flight
+    PhaseHistograms hist;
+    size_t chunk_size = 0;    // Set for --sweep points only
+    std::string label = "read";  // What was measured: read, write, mixed_read, sweep, ...
+    double seconds = 0;
+    long long ops = 0;        // File accesses
+    long long bytes = 0;
+    IoCounters io = {};       // Device and process counters over the run (--io_stats)
+};
+
+using ReportFields = std::vector<std::pair<std::string, std::string>>;
+
+// `value` as a quoted JSON string
+static inline std::string json_string(const std::string& value) {
+    std::string out = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if ((unsigned char)c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+// `value` as a CSV field, quoted only when it needs to be
+static inline std::string csv_field(const std::string& value) {
+    if (value.find_first_of(",\"\n") == std::string::npos) return value;
+    std::string out = "\"";
+    for (char c : value) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    return out + "\"";
+}
+
+static inline std::string read_first_line(const std::string& path) {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+// Value of the first "key<sep>value" line in `path` starting with `key`
+static inline std::string read_keyed_value(const std::string& path, const std::string& key) {
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.compare(0, key.size(), key) != 0) continue;
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        size_t start = line.find_first_not_of(" \t", colon + 1);
+        return start == std::string::npos ? "" : line.substr(start);
+    }
+    return "";
+}
+
+static inline std::string filesystem_name(long type) {
+    switch ((unsigned long)type) {
+        case 0xEF53: return "ext4";
+        case 0x58465342: return "xfs";
+        case 0x9123683E: return "btrfs";
+        case 0x01021994: return "tmpfs";
+        case 0x794C7630: return "overlayfs";
+        case 0x6969: return "nfs";
+        case 0x2FC12FC1: return "zfs";
+        case 0xF2F52010: return "f2fs";
+        case 0x65735546: return "fuse";
+        case 0xFF534D42: return "cifs";
+        case 0x4244: return "hfs";
+        default: {
+            char hex[32];
+            snprintf(hex, sizeof(hex), "0x%lx", (unsigned long)type);
+            return hex;
+        }
+    }
+}
+
+// Host, kernel, CPU and the filesystem and block device holding `path`
+static inline ReportFields collect_environment(const std::string& path) {
+    ReportFields env;
+    char host[256] = {0};
+    gethostname(host, sizeof(host) - 1);
+    env.emplace_back("hostname", host);
+    struct utsname name;
+    if (uname(&name) == 0) {
+        env.emplace_back("kernel", std::string(name.sysname) + " " + name.release);
+        env.emplace_back("kernel_version", name.version);
+        env.emplace_back("machine", name.machine);
+    }
+    env.emplace_back("cpu_count", std::to_string(std::thread::hardware_concurrency()));
+    env.emplace_back("cpu_model", read_keyed_value("/proc/cpuinfo", "model name"));
+    env.emplace_back("mem_total", read_keyed_value("/proc/meminfo", "MemTotal"));
+
+    struct statfs fs;
+    env.emplace_back("fs_type", statfs(path.c_str(), &fs) == 0 ? filesystem_name((long)fs.f_type) : "");
+
+    // The block device behind `path`; a partition keeps its model on the parent
+    std::string device, model, rotational;
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0 && major(st.st_dev) != 0) {
+        std::string sys_link = "/sys/dev/block/" + std::to_string(major(st.st_dev)) + ":" +
+                               std::to_string(minor(st.st_dev));
+        char resolved[PATH_MAX];
+        if (realpath(sys_link.c_str(), resolved)) {
+            std::string dir = resolved;
+            device = dir.substr(dir.rfind('/') + 1);
+            std::string parent = dir.substr(0, dir.rfind('/'));
+            model = read_first_line(dir + "/device/model");
+            if (model.empty()) model = read_first_line(parent + "/device/model");
+            rotational = read_first_line(dir + "/queue/rotational");
+            if (rotational.empty()) rotational = read_first_line(parent + "/queue/rotational");
+        }
+    }
+    while (!model.empty() && model.back() == ' ') model.pop_back();
+    env.emplace_back("device", device);
+    env.emplace_back("device_model", model);
+    env.emplace_back("device_rotational", rotational);
+
+    char timestamp[32];
+    time_t now = time(nullptr);
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    env.emplace_back("timestamp", timestamp);
+    return env;
+}
+
+class ResultReport {
+public:
+    // Sets (or replaces) a parameter
+    void param(const std::string& name, const std::string& value) {
+        for (auto& p : params) {
+            if (p.first == name) {
+                p.second = value;
+                return;
+            }
+        }
+        params.emplace_back(name, value);
+    }
+
+    void timing_ms(const std::string& phase, double ms) { timings.emplace_back(phase, ms); }
+
+    // Writes the report in `format` ("json" or "csv") to `path` ("-" = stdout).
+    bool write(const std::string& format, const std::string& path, const std::string& data_path,
+               const std::vector<LatencyRun>& runs) const {
+        ReportFields env = collect_environment(data_path);
+        std::ostringstream out;
+        if (format == "json") {
+            write_json(out, env, runs);
+        } else {
+            write_csv(out, env, runs);
+        }
+        if (path == "-") {
+            std::cout << out.str();
+            return true;
+        }
+        std::ofstream file(path);
+        file << out.str();
+        if (!file) {
+            std::cerr << "Error writing results file " << path << std::endl;
+            return false;
+        }
+        std::cout << "Results (" << format << ") written to " << path << std::endl;
+        return true;
+    }
+
+private:
+    static constexpr const char* PHASES[] = {"open", "map", "read", "write", "sync", "close", "file", "scheduled"};
+
+    static const LatencyHistogram& phase(const PhaseHistograms& hist, const std::string& name) {
+        if (name == "open") return hist.open;
+        if (name == "map") return hist.map;
+        if (name == "read") return hist.read;
+        if (name == "write") return hist.write;
+        if (name == "sync") return hist.sync;
+        if (name == "close") return hist.close;
+        if (name == "scheduled") return hist.scheduled;
+        return hist.file;
+    }
+
+    // Throughput fields of a run, in output order
+    static ReportFields run_fields(const LatencyRun& run) {
+        double seconds = run.seconds > 0 ? run.seconds : 0;
+        auto num = [](double v) {
+            std::ostringstream s;
+            s << v;
+            return s.str();
+        };
+        return {{"label", run.label},
+                {"inflight", std::to_string(run.inflight)},
+                {"chunk_size", std::to_string(run.chunk_size)},
+                {"seconds", num(seconds)},
+                {"ops", std::to_string(run.ops)},
+                {"bytes", std::to_string(run.bytes)},
+                {"iops", num(seconds > 0 ? run.ops / seconds : 0)},
+                {"gb_per_sec", num(seconds > 0 ? run.bytes / seconds / 1e9 : 0)},
+                {"dev_read_ios", run.io.device ? std::to_string(run.io.read_ios) : ""},
+                {"dev_read_bytes", run.io.device ? std::to_string(run.io.read_bytes) : ""},
+                {"dev_read_merges", run.io.device ? std::to_string(run.io.read_merges) : ""},
+                {"dev_write_ios", run.io.device ? std::to_string(run.io.write_ios) : ""},
+                {"dev_write_bytes", run.io.device ? std::to_string(run.io.write_bytes) : ""},
+                {"dev_write_merges", run.io.device ? std::to_string(run.io.write_merges) : ""},
+                {"dev_busy_ms", run.io.device ? std::to_string(run.io.busy_ms) : ""},
+                {"dev_queue_ms", run.io.device ? std::to_string(run.io.queue_ms) : ""},
+                {"proc_read_bytes", std::to_string(run.io.proc_read_bytes)},
+                {"proc_write_bytes", std::to_string(run.io.proc_write_bytes)},
+                {"cpu_user_ms", num(run.io.cpu_user_us / 1000.0)},
+                {"cpu_sys_ms", num(run.io.cpu_sys_us / 1000.0)},
+                {"host_cpu_busy_pct",
+                 num(run.io.host_total_ticks > 0 ? 100.0 * run.io.host_busy_ticks / run.io.host_total_ticks : 0)}};
+    }
+
+    static ReportFields phase_fields(const LatencyHistogram& h) {
+        auto num = [](double v) {
+            std::ostringstream s;
+            s << v;
+            return s.str();
+        };
+        return {{"count", std::to_string(h.count())},
+                {"avg_us", num(h.mean_ns() / 1000.0)},
+                {"min_us", num(h.min_ns() / 1000.0)},
+                {"p50_us", num(h.percentile_ns(50) / 1000.0)},
+                {"p90_us", num(h.percentile_ns(90) / 1000.0)},
+                {"p99_us", num(h.percentile_ns(99) / 1000.0)},
+                {"p99.9_us", num(h.percentile_ns(99.9) / 1000.0)},
+                {"max_us", num(h.max_ns() / 1000.0)}};
+    }
+
+    void write_json(std::ostream& out, const ReportFields& env, const std::vector<LatencyRun>& runs) const {
+        auto object = [&](const ReportFields& fields) {
+            out << "{";
+            for (size_t i = 0; i < fields.size(); i++) {
+                out << (i ? ", " : "") << json_string(fields[i].first) << ": " << json_string(fields[i].second);
+            }
+            out << "}";
+        };
+        out << "{\"parameters\": ";
+        object(params);
+        out << ", \"environment\": ";
+        object(env);
+        out << ", \"timings_ms\": {";
+        for (size_t i = 0; i < timings.size(); i++) {
+            out << (i ? ", " : "") << json_string(timings[i].first) << ": " << timings[i].second;
+        }
+        out << "}, \"runs\": [";
+        for (size_t r = 0; r < runs.size(); r++) {
+            ReportFields fields = run_fields(runs[r]);
+            out << (r ? ", " : "") << "{";
+            for (size_t i = 0; i < fields.size(); i++) {
+                // Numbers stay numbers, the label is the only string, and
+                // counters that were not measured are null
+                out << (i ? ", " : "") << json_string(fields[i].first) << ": "
+                    << (i == 0 ? json_string(fields[i].second)
+                               : fields[i].second.empty() ? "null" : fields[i].second);
+            }
+            out << ", \"phases\": {";
+            bool first = true;
+            for (const auto& recorded : runs[r].hist.recorded()) {
+                out << (first ? "" : ", ") << json_string(recorded.first) << ": {";
+                ReportFields stats = phase_fields(*recorded.second);
+                for (size_t i = 0; i < stats.size(); i++) {
+                    out << (i ? ", " : "") << json_string(stats[i].first) << ": " << stats[i].second;
+                }
+                out << "}";
+                first = false;
+            }
+            out << "}}";
+        }
+        out << "]}" << std::endl;
+    }
+
+    void write_csv(std::ostream& out, const ReportFields& env, const std::vector<LatencyRun>& runs) const {
+        // Header from the first row's layout; every row has the same columns
+        std::vector<std::string> header;
+        for (const auto& f : run_fields(LatencyRun{0, PhaseHistograms()})) header.push_back(f.first);
+        for (const char* name : PHASES) {
+            for (const auto& f : phase_fields(LatencyHistogram())) header.push_back(std::string(name) + "_" + f.first);
+        }
+        for (const auto& t : timings) header.push_back("timing_" + t.first + "_ms");
+        for (const auto& p : params) header.push_back("param_" + p.first);
+        for (const auto& e : env) header.push_back("env_" + e.first);
+        for (size_t i = 0; i < header.size(); i++) out << (i ? "," : "") << csv_field(header[i]);
+        out << "\n";
+
+        for (const auto& run : runs) {
+            std::vector<std::string> row;
+            for (const auto& f : run_fields(run)) row.push_back(f.second);
+            for (const char* name : PHASES) {
+                const LatencyHistogram& h = phase(run.hist, name);
+                for (const auto& f : phase_fields(h)) row.push_back(h.count() > 0 ? f.second : "");
+            }
+            for (const auto& t : timings) {
+                std::ostringstream s;
+                s << t.second;
+                row.push_back(s.str());
+            }
+            for (const auto& p : params) row.push_back(p.second);
+            for (const auto& e : env) row.push_back(e.second);
+            for (size_t i = 0; i < row.size(); i++) out << (i ? "," : "") << csv_field(row[i]);
+            out << "\n";
+        }
+        out.flush();
+    }
+
+    ReportFields params;
+    std::vector<std::pair<std::string, double>> timings;
+};
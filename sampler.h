@@ -0,0 +1,185 @@
+#pragma once
+
+// Interval time series of the measured loops: files completed, bytes and the
+// latency distribution per fixed interval (--sample_ms), so throttling, garbage
+// collection stalls and cache warmup show up instead of vanishing into a run
+// average. Every recording thread owns a slot of relaxed atomic counters (one
+// writer, so plain load/store increments, no locked read-modify-write); a
+// background thread snapshots the slots once per interval and diffs them.
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "latency_histogram.h"
+
+class IntervalSampler {
+public:
+    struct Sample {
+        double end_ms;        // Interval end, since start()
+        double seconds;       // Interval length (the last one may be short)
+        uint64_t files;
+        uint64_t bytes;
+        LatencyHistogram latency;  // File latencies completed in the interval
+    };
+
+    explicit IntervalSampler(int interval_ms) : interval(std::chrono::milliseconds(interval_ms)) {}
+    ~IntervalSampler() { stop(); }
+
+    IntervalSampler(const IntervalSampler&) = delete;
+    IntervalSampler& operator=(const IntervalSampler&) = delete;
+
+    void start() {
+        start_time = std::chrono::steady_clock::now();
+        last_time = start_time;
+        running = true;
+        thread = std::thread([this] { run(); });
+    }
+
+    // Takes the final (partial) sample and joins the sampling thread
+    void stop() {
+        if (!thread.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        wake.notify_one();
+        thread.join();
+        take_sample(std::chrono::steady_clock::now());
+    }
+
+    // One completed file access of `bytes` that took `ns`, from any thread
+    void record(uint64_t ns, uint64_t bytes) {
+        Slot& slot = local_slot();
+        increment(slot.files, 1);
+        increment(slot.bytes, bytes);
+        increment(slot.buckets[LatencyHistogram::bucket_of(ns)], 1);
+    }
+
+    const std::vector<Sample>& samples() const { return series; }
+
+    void print() const {
+        std::cout << "Time series (" << interval.count() << " ms intervals):" << std::endl;
+        std::cout << "  t_ms  files  files/s  MB/s  p50_us  p99_us  max_us" << std::endl;
+        for (const auto& sample : series) {
+            double seconds = sample.seconds > 0 ? sample.seconds : 1e-9;
+            std::cout << "  " << sample.end_ms << "  " << sample.files << "  " << (sample.files / seconds)
+                      << "  " << (sample.bytes / seconds / (1024.0 * 1024.0)) << "  "
+                      << sample.latency.percentile_ns(50) / 1000.0 << "  "
+                      << sample.latency.percentile_ns(99) / 1000.0 << "  "
+                      << sample.latency.max_ns() / 1000.0 << std::endl;
+        }
+    }
+
+    // Writes the series as CSV. Returns false on error.
+    bool write_csv(const std::string& csv_path) const {
+        std::ofstream out(csv_path);
+        out << "t_ms,seconds,files,bytes,files_per_sec,mb_per_sec,p50_us,p99_us,max_us\n";
+        for (const auto& sample : series) {
+            double seconds = sample.seconds > 0 ? sample.seconds : 1e-9;
+            out << sample.end_ms << "," << sample.seconds << "," << sample.files << "," << sample.bytes << ","
+                << (sample.files / seconds) << "," << (sample.bytes / seconds / (1024.0 * 1024.0)) << ","
+                << sample.latency.percentile_ns(50) / 1000.0 << "," << sample.latency.percentile_ns(99) / 1000.0
+                << "," << sample.latency.max_ns() / 1000.0 << "\n";
+        }
+        out.flush();
+        if (!out) {
+            std::cerr << "Error writing time series file " << csv_path << std::endl;
+            return false;
+        }
+        std::cout << "Time series written to " << csv_path << std::endl;
+        return true;
+    }
+
+private:
+    using Counter = std::atomic<uint64_t>;
+
+    struct alignas(64) Slot {
+        Counter files{0};
+        Counter bytes{0};
+        std::array<Counter, LatencyHistogram::NUM_BUCKETS> buckets{};
+    };
+
+    // What the sampler saw of a slot at the previous sample
+    struct Snapshot {
+        uint64_t files = 0;
+        uint64_t bytes = 0;
+        std::vector<uint64_t> buckets = std::vector<uint64_t>(LatencyHistogram::NUM_BUCKETS);
+    };
+
+    // Only the owning thread writes a slot, so a relaxed load/store is enough
+    static void increment(Counter& counter, uint64_t n) {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    Slot& local_slot() {
+        thread_local IntervalSampler* owner = nullptr;
+        thread_local Slot* slot = nullptr;
+        if (owner != this) {
+            std::lock_guard<std::mutex> lock(mutex);
+            slots.push_back(std::make_unique<Slot>());
+            snapshots.emplace_back();
+            slot = slots.back().get();
+            owner = this;
+        }
+        return *slot;
+    }
+
+    void run() {
+        auto next = start_time + interval;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (running) {
+            if (wake.wait_until(lock, next, [this] { return !running; })) break;
+            lock.unlock();
+            take_sample(next);
+            lock.lock();
+            next += interval;
+        }
+    }
+
+    void take_sample(std::chrono::steady_clock::time_point now) {
+        Sample sample;
+        sample.end_ms = std::chrono::duration<double, std::milli>(now - start_time).count();
+        sample.seconds = std::chrono::duration<double>(now - last_time).count();
+        sample.files = 0;
+        sample.bytes = 0;
+        last_time = now;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t s = 0; s < slots.size(); s++) {
+            const Slot& slot = *slots[s];
+            Snapshot& seen = snapshots[s];
+            uint64_t files = slot.files.load(std::memory_order_relaxed);
+            uint64_t bytes = slot.bytes.load(std::memory_order_relaxed);
+            sample.files += files - seen.files;
+            sample.bytes += bytes - seen.bytes;
+            seen.files = files;
+            seen.bytes = bytes;
+            for (int b = 0; b < LatencyHistogram::NUM_BUCKETS; b++) {
+                uint64_t count = slot.buckets[b].load(std::memory_order_relaxed);
+                sample.latency.record_bucket(b, count - seen.buckets[b]);
+                seen.buckets[b] = count;
+            }
+        }
+        series.push_back(sample);
+    }
+
+    const std::chrono::milliseconds interval;
+    std::chrono::steady_clock::time_point start_time;
+    std::chrono::steady_clock::time_point last_time;
+    bool running = false;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<std::unique_ptr<Slot>> slots;
+    std::vector<Snapshot> snapshots;
+    std::vector<Sample> series;
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+// Single-slab layout, the KVC2 strategy of file_manager.py measured from the
+// main loops: entry i of the N-file set lives in slot i of one preallocated
+// file or raw block device, at (i - 1) * slot_size. Slots are a multiple of
+// 4096 bytes so O_DIRECT offsets stay aligned. The loops check an fd out of a
+// shared pool for every access instead of opening a file, and pread()/pwrite()
+// at the slot offset, so no filesystem metadata is touched per access.
+
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Slab {
+public:
+    ~Slab() {
+        for (int fd : fd_queue) close(fd);
+    }
+
+    // Opens `num_fds` descriptors on `path` and checks that it holds
+    // `num_slots` slots of `slot_size` bytes. Returns false on error.
+    bool open(const std::string& path, int num_slots, long long slot_size, int num_fds,
+              bool writable, bool direct, bool dsync) {
+        this->path = path;
+        this->slot_size = slot_size;
+        int flags = (writable ? O_RDWR : O_RDONLY) | (dsync ? O_DSYNC : 0);
+        for (int i = 0; i < num_fds; i++) {
+            int fd = ::open(path.c_str(), flags | (direct ? O_DIRECT : 0));
+            if (fd == -1 && direct && errno == EINVAL) {
+                std::cerr << "Error opening slab with O_DIRECT: " << path
+                          << " (errno: " << errno << ")" << std::endl;
+                fd = ::open(path.c_str(), flags);
+                if (fd != -1) {
+                    std::cout << "Warning: O_DIRECT not supported, using the slab without it" << std::endl;
+                    direct = false;
+                }
+            }
+            if (fd == -1) {
+                std::cerr << "Error opening slab: " << path << " (errno: " << errno << ")" << std::endl;
+                return false;
+            }
+            fd_queue.push_back(fd);
+        }
+
+        long long size = slab_size(fd_queue.front());
+        if (size < 0) {
+            std::cerr << "Error getting the size of slab: " << path << " (errno: " << errno << ")" << std::endl;
+            return false;
+        }
+        if (size < (long long)num_slots * slot_size) {
+            std::cerr << "Error: slab " << path << " holds " << size << " bytes, "
+                      << (long long)num_slots * slot_size << " needed for " << num_slots << " slots of "
+                      << slot_size << " bytes (run with CREATE_DELETE_MODE=1 to create it)" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    off_t slot_offset(int file_num) const { return (off_t)(file_num - 1) * slot_size; }
+
+    const std::string& name() const { return path; }
+
+    // Takes an fd out of the pool, waiting while all are in use
+    int get_fd() {
+        std::unique_lock<std::mutex> lock(fd_mutex);
+        fd_available.wait(lock, [this] { return !fd_queue.empty(); });
+        int fd = fd_queue.back();
+        fd_queue.pop_back();
+        return fd;
+    }
+
+    void put_fd(int fd) {
+        {
+            std::lock_guard<std::mutex> lock(fd_mutex);
+            fd_queue.push_back(fd);
+        }
+        fd_available.notify_one();
+    }
+
+    // Bytes in a regular file or block device, or -1 on error
+    static long long slab_size(int fd) {
+        struct stat st;
+        if (fstat(fd, &st) != 0) return -1;
+        if (S_ISBLK(st.st_mode)) {
+            unsigned long long bytes;
+            if (ioctl(fd, BLKGETSIZE64, &bytes) != 0) return -1;
+            return (long long)bytes;
+        }
+        return (long long)st.st_size;
+    }
+
+private:
+    std::string path;
+    long long slot_size = 0;
+    std::mutex fd_mutex;
+    std::condition_variable fd_available;
+    std::vector<int> fd_queue;
+};
@@ -0,0 +1,525 @@
+#pragma once
+
+// Benchmark matrix runner for --suite=FILE. The config describes a parameter
+// matrix; every cell of it runs as a child process of this binary, with its
+// console output in <log_dir>/cell<i>.log and its --output=csv report in
+// <log_dir>/cell<i>.csv. The reports are merged into one comparison table
+// (and a JSON or CSV file with --output/--output_file). Config lines:
+//   NAME = VALUE           fixed parameter of every cell: a positional one
+//                          (N, K, ITER, PATH, DROP_CACHE_INITIAL, SKIP_READ,
+//                          SKIP_WRITE, CHUNK_SIZE, PARALLEL_READ) or an option
+//                          name without the dashes (engine = io_uring)
+//   options = --a=1 --b    options of every cell, as on the command line
+//   axis NAME = V1 V2 ...  one matrix dimension; the last axis varies fastest
+//   exclude NAME=V ...     skip the cells matching all of these values
+//   timeout = SECONDS      kill a cell that runs longer (default: none)
+//   log_dir = DIR          where the logs and reports go (default suite_logs)
+// '#' starts a comment. Options given on the command line next to --suite
+// apply to every cell over the config's fixed values; axis values win over
+// both. The runner owns CREATE_DELETE_MODE: cells are ordered so that those
+// sharing a file set (same N, K, PATH, SKIP_WRITE, layout, fill, ...) run back
+// to back, and the set is populated by the first of them only. A cell that
+// writes, deletes or runs a manager (or that fails) leaves the set unusable,
+// so cells that only read run ahead of it and the next cell repopulates.
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "report.h"
+
+class SuiteRunner {
+public:
+    // Reads the matrix from `path`. Returns false on a malformed config.
+    bool load(const std::string& path) {
+        config_path = path;
+        std::ifstream in(path);
+        if (!in) {
+            std::cerr << "Error opening suite config " << path << " (errno: " << errno << ")" << std::endl;
+            return false;
+        }
+        std::string line;
+        int line_number = 0;
+        while (std::getline(in, line)) {
+            line_number++;
+            size_t hash = line.find('#');
+            if (hash != std::string::npos) line.resize(hash);
+            line = trim(line);
+            if (line.empty()) continue;
+            if (!parse_line(line)) {
+                std::cerr << "Error in suite config " << path << " line " << line_number << ": " << line << std::endl;
+                return false;
+            }
+        }
+        if (fixed.count("CREATE_DELETE_MODE")) {
+            std::cerr << "The suite decides CREATE_DELETE_MODE per cell; remove it from " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Runs every cell. `positionals` are main's positional parameters as
+    // given (or defaulted) on the command line, `forwarded` the other options
+    // given there. The merged report goes to `output_file` in `format` (json
+    // or csv) unless `format` is empty. Returns false if a cell failed.
+    bool run(const std::string& self, const std::vector<std::pair<std::string, std::string>>& positionals,
+             const std::map<std::string, std::string>& forwarded, const std::string& format,
+             const std::string& output_file) {
+        std::vector<Cell> cells = expand(positionals, forwarded);
+        if (cells.empty()) {
+            std::cerr << "Suite " << config_path << " has no cells left after its excludes" << std::endl;
+            return false;
+        }
+        std::error_code ec;
+        std::filesystem::create_directories(log_dir, ec);
+        if (ec) {
+            std::cerr << "Error creating suite log directory " << log_dir << " (" << ec.message() << ")" << std::endl;
+            return false;
+        }
+        std::set<std::string> file_sets;
+        for (const Cell& cell : cells) file_sets.insert(cell.file_set);
+        std::cout << "Suite " << config_path << ": " << cells.size() << " cells, " << file_sets.size()
+                  << " file sets, logs in " << log_dir << std::endl;
+
+        bool all_ok = true;
+        std::string populated;  // File set left intact by the previous cell
+        for (size_t c = 0; c < cells.size(); c++) {
+            Cell& cell = cells[c];
+            bool create = cell.file_set != populated;
+            cell.args[4] = create ? "1" : "0";
+            std::string base = log_dir + "/cell" + std::to_string(c + 1);
+            cell.log = base + ".log";
+            cell.report = base + ".csv";
+            std::vector<std::string> argv = cell.args;
+            argv.insert(argv.begin(), self);
+            argv.push_back("--output=csv");
+            argv.push_back("--output_file=" + cell.report);
+
+            std::cout << "[" << (c + 1) << "/" << cells.size() << "] " << describe(cell)
+                      << (create ? " (populates)" : "") << " ... " << std::flush;
+            unlink(cell.report.c_str());
+            auto start = std::chrono::steady_clock::now();
+            cell.status = run_child(argv, cell.log);
+            cell.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (cell.status == "ok" && !read_csv(cell.report, cell.header, cell.rows)) cell.status = "no report";
+            std::cout << cell.status << " in " << cell.seconds << " s" << std::endl;
+            if (cell.status != "ok") all_ok = false;
+            populated = (cell.status == "ok" && !cell.modifies) ? cell.file_set : "";
+        }
+
+        print_table(cells);
+        if (!format.empty() && !write_report(cells, format, output_file)) return false;
+        return all_ok;
+    }
+
+private:
+    struct Axis {
+        std::string name;
+        std::vector<std::string> values;
+    };
+
+    struct Cell {
+        std::vector<std::pair<std::string, std::string>> axis_values;
+        std::vector<std::string> args;   // Positionals, then --name=value options
+        std::vector<std::string> dropped;
+        std::string file_set;            // Cells with equal keys share a populated file set
+        bool modifies = false;           // Leaves the file set changed
+        std::string log;
+        std::string report;
+        std::string status;
+        double seconds = 0;
+        std::vector<std::string> header;
+        std::vector<std::vector<std::string>> rows;
+    };
+
+    static std::string trim(const std::string& s) {
+        size_t first = s.find_first_not_of(" \t\r");
+        if (first == std::string::npos) return "";
+        size_t last = s.find_last_not_of(" \t\r");
+        return s.substr(first, last - first + 1);
+    }
+
+    static std::vector<std::string> split(const std::string& s) {
+        std::istringstream in(s);
+        std::vector<std::string> words;
+        std::string word;
+        while (in >> word) words.push_back(word);
+        return words;
+    }
+
+    static bool parse_pair(const std::string& word, std::pair<std::string, std::string>& pair) {
+        std::string w = word.rfind("--", 0) == 0 ? word.substr(2) : word;
+        size_t eq = w.find('=');
+        if (w.empty() || eq == 0) return false;
+        pair = eq == std::string::npos ? std::make_pair(w, std::string("1"))
+                                       : std::make_pair(w.substr(0, eq), w.substr(eq + 1));
+        return true;
+    }
+
+    bool parse_line(const std::string& line) {
+        if (line.rfind("exclude ", 0) == 0) {
+            std::vector<std::pair<std::string, std::string>> rule;
+            for (const std::string& word : split(line.substr(8))) {
+                std::pair<std::string, std::string> pair;
+                if (!parse_pair(word, pair) || word.find('=') == std::string::npos) return false;
+                rule.push_back(pair);
+            }
+            excludes.push_back(rule);
+            return !rule.empty();
+        }
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) return false;
+        std::string key = trim(line.substr(0, eq));
+        std::string value = trim(line.substr(eq + 1));
+        if (key.rfind("axis ", 0) == 0) {
+            Axis axis = {trim(key.substr(5)), split(value)};
+            if (axis.name.empty() || axis.values.empty()) return false;
+            axes.push_back(axis);
+            return true;
+        }
+        if (key == "options") {
+            for (const std::string& word : split(value)) {
+                std::pair<std::string, std::string> pair;
+                if (!parse_pair(word, pair)) return false;
+                fixed[pair.first] = pair.second;
+            }
+            return true;
+        }
+        if (key == "timeout") {
+            try {
+                timeout_seconds = std::stod(value);
+            } catch (const std::exception&) {
+                return false;
+            }
+            return timeout_seconds >= 0;
+        }
+        if (key == "log_dir") {
+            log_dir = value;
+            return !value.empty();
+        }
+        if (key.empty() || key == "axis" || key.find(' ') != std::string::npos) return false;
+        fixed[key] = value;
+        return true;
+    }
+
+    std::vector<Cell> expand(const std::vector<std::pair<std::string, std::string>>& positionals,
+                             const std::map<std::string, std::string>& forwarded) const {
+        std::vector<Cell> cells;
+        std::vector<size_t> index(axes.size(), 0);
+        while (true) {
+            std::map<std::string, std::string> values = fixed;
+            for (const auto& option : forwarded) values[option.first] = option.second;
+            Cell cell;
+            for (size_t a = 0; a < axes.size(); a++) {
+                values[axes[a].name] = axes[a].values[index[a]];
+                cell.axis_values.emplace_back(axes[a].name, axes[a].values[index[a]]);
+            }
+            if (!excluded(values)) {
+                build(cell, values, positionals);
+                cells.push_back(cell);
+            }
+            // Odometer over the axes, last one fastest
+            size_t a = axes.size();
+            while (a > 0 && ++index[a - 1] == axes[a - 1].values.size()) index[--a] = 0;
+            if (a == 0) break;
+        }
+        // Cells sharing a file set run back to back, those that change it last
+        std::stable_sort(cells.begin(), cells.end(), [](const Cell& x, const Cell& y) {
+            if (x.file_set != y.file_set) return x.file_set < y.file_set;
+            return !x.modifies && y.modifies;
+        });
+        return cells;
+    }
+
+    bool excluded(const std::map<std::string, std::string>& values) const {
+        for (const auto& rule : excludes) {
+            bool match = true;
+            for (const auto& pair : rule) {
+                auto it = values.find(pair.first);
+                if (it == values.end() || it->second != pair.second) match = false;
+            }
+            if (match) return true;
+        }
+        return false;
+    }
+
+    void build(Cell& cell, std::map<std::string, std::string> values,
+               const std::vector<std::pair<std::string, std::string>>& positionals) const {
+        auto value = [&](const std::string& name, const std::string& fallback) {
+            auto it = values.find(name);
+            return it == values.end() ? fallback : it->second;
+        };
+        for (const auto& positional : positionals) {
+            cell.args.push_back(value(positional.first, positional.second));
+            values.erase(positional.first);
+        }
+        std::string manager = value("manager", "");
+        std::string workload = value("workload", "read");
+        cell.modifies = !manager.empty() || workload != "read";
+
+        // Options the cell's mode rejects are left out rather than failing the cell
+        std::vector<std::string> drop;
+        if (!manager.empty()) drop = {"duration", "warmup", "repeat", "cache_state", "sample_ms"};
+        if (workload == "mixed" || workload == "replay" || values.count("inflight") ||
+            values.count("sweep_chunks") || values.count("sweep_depths")) {
+            drop.push_back("repeat");
+        }
+        for (const std::string& name : drop) {
+            if (values.erase(name)) cell.dropped.push_back(name);
+        }
+        for (const auto& option : values) cell.args.push_back("--" + option.first + "=" + option.second);
+
+        // What the populate step depends on
+        std::ostringstream key;
+        key << cell.args[0] << "|" << cell.args[1] << "|" << cell.args[3] << "|" << cell.args[7];
+        for (const char* name : {"layout", "slab_path", "dir_fanout", "dir_levels", "fill", "fallocate",
+                                 "populate_o_direct", "verify"}) {
+            key << "|" << value(name, "");
+        }
+        cell.file_set = key.str();
+    }
+
+    static std::string describe(const Cell& cell) {
+        std::string text;
+        for (const auto& pair : cell.axis_values) text += (text.empty() ? "" : " ") + pair.first + "=" + pair.second;
+        for (const std::string& name : cell.dropped) text += " (without --" + name + ")";
+        return text.empty() ? "single cell" : text;
+    }
+
+    // Runs `argv` with stdout and stderr in `log`; "ok", "exit N", "signal N" or "timeout"
+    std::string run_child(const std::vector<std::string>& argv, const std::string& log) const {
+        pid_t pid = fork();
+        if (pid < 0) return "fork failed (errno " + std::to_string(errno) + ")";
+        if (pid == 0) {
+            int fd = open(log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd >= 0) {
+                dup2(fd, STDOUT_FILENO);
+                dup2(fd, STDERR_FILENO);
+                close(fd);
+            }
+            std::vector<char*> c_argv;
+            for (const std::string& arg : argv) c_argv.push_back(const_cast<char*>(arg.c_str()));
+            c_argv.push_back(nullptr);
+            execv("/proc/self/exe", c_argv.data());
+            _exit(127);
+        }
+        auto start = std::chrono::steady_clock::now();
+        int status = 0;
+        while (true) {
+            pid_t done = waitpid(pid, &status, WNOHANG);
+            if (done == pid) break;
+            if (done < 0 && errno != EINTR) return "wait failed (errno " + std::to_string(errno) + ")";
+            if (timeout_seconds > 0 &&
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > timeout_seconds) {
+                kill(pid, SIGKILL);
+                waitpid(pid, &status, 0);
+                return "timeout";
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        if (WIFSIGNALED(status)) return "signal " + std::to_string(WTERMSIG(status));
+        if (WEXITSTATUS(status) != 0) return "exit " + std::to_string(WEXITSTATUS(status));
+        return "ok";
+    }
+
+    static bool read_csv(const std::string& path, std::vector<std::string>& header,
+                         std::vector<std::vector<std::string>>& rows) {
+        std::ifstream in(path);
+        if (!in) return false;
+        std::string line;
+        bool first = true;
+        while (std::getline(in, line)) {
+            std::vector<std::string> fields;
+            std::string field;
+            bool quoted = false;
+            for (size_t i = 0; i < line.size(); i++) {
+                char c = line[i];
+                if (quoted) {
+                    if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                        field += '"';
+                        i++;
+                    } else if (c == '"') {
+                        quoted = false;
+                    } else {
+                        field += c;
+                    }
+                } else if (c == '"') {
+                    quoted = true;
+                } else if (c == ',') {
+                    fields.push_back(field);
+                    field.clear();
+                } else {
+                    field += c;
+                }
+            }
+            fields.push_back(field);
+            if (first) {
+                header = fields;
+                first = false;
+            } else {
+                rows.push_back(fields);
+            }
+        }
+        return !header.empty();
+    }
+
+    static std::string column(const Cell& cell, const std::vector<std::string>& row, const std::string& name) {
+        for (size_t i = 0; i < cell.header.size() && i < row.size(); i++) {
+            if (cell.header[i] == name) return row[i];
+        }
+        return "";
+    }
+
+    void print_table(const std::vector<Cell>& cells) const {
+        std::cout << std::endl << "Suite results (latency of whole file accesses, us):" << std::endl;
+        std::cout << "  cell";
+        for (const Axis& axis : axes) std::cout << "  " << axis.name;
+        std::cout << "  status  label  files/s  MB/s  p50  p99  p99.9" << std::endl;
+        for (size_t c = 0; c < cells.size(); c++) {
+            const Cell& cell = cells[c];
+            std::string values;
+            for (const auto& pair : cell.axis_values) values += "  " + pair.second;
+            if (cell.rows.empty()) {
+                std::cout << "  " << (c + 1) << values << "  " << cell.status << std::endl;
+                continue;
+            }
+            for (const auto& row : cell.rows) {
+                double seconds = std::atof(column(cell, row, "seconds").c_str());
+                double bytes = std::atof(column(cell, row, "bytes").c_str());
+                std::cout << "  " << (c + 1) << values << "  " << cell.status << "  " << column(cell, row, "label")
+                          << "  " << column(cell, row, "iops") << "  "
+                          << (seconds > 0 ? bytes / seconds / (1024.0 * 1024.0) : 0) << "  "
+                          << column(cell, row, "file_p50_us") << "  " << column(cell, row, "file_p99_us") << "  "
+                          << column(cell, row, "file_p99.9_us") << std::endl;
+            }
+        }
+    }
+
+    static bool is_number(const std::string& s) {
+        if (s.empty()) return false;
+        char* end = nullptr;
+        strtod(s.c_str(), &end);
+        return end && *end == '\0';
+    }
+
+    // Result columns of the per-cell reports (parameters and environment are kept apart)
+    static bool result_column(const std::string& name) {
+        return name.rfind("param_", 0) != 0 && name.rfind("env_", 0) != 0;
+    }
+
+    bool write_report(const std::vector<Cell>& cells, const std::string& format, const std::string& path) const {
+        std::ostringstream out;
+        if (format == "json") {
+            write_json(out, cells);
+        } else {
+            write_csv(out, cells);
+        }
+        if (path == "-") {
+            std::cout << out.str();
+            return true;
+        }
+        std::ofstream file(path);
+        file << out.str();
+        if (!file) {
+            std::cerr << "Error writing suite results file " << path << std::endl;
+            return false;
+        }
+        std::cout << "Suite results (" << format << ") written to " << path << std::endl;
+        return true;
+    }
+
+    void write_json(std::ostream& out, const std::vector<Cell>& cells) const {
+        auto object = [&](const Cell& cell, const std::vector<std::string>& row, bool results) {
+            out << "{";
+            bool first = true;
+            for (size_t i = 0; i < cell.header.size() && i < row.size(); i++) {
+                const std::string& name = cell.header[i];
+                if (result_column(name) != results) continue;
+                std::string key = results ? name : name.substr(name.find('_') + 1);
+                const std::string& v = row[i];
+                out << (first ? "" : ", ") << json_string(key) << ": "
+                    << (!results ? json_string(v) : v.empty() ? "null" : is_number(v) ? v : json_string(v));
+                first = false;
+            }
+            out << "}";
+        };
+        out << "{\"suite\": " << json_string(config_path) << ", \"axes\": [";
+        for (size_t a = 0; a < axes.size(); a++) out << (a ? ", " : "") << json_string(axes[a].name);
+        out << "], \"cells\": [";
+        for (size_t c = 0; c < cells.size(); c++) {
+            const Cell& cell = cells[c];
+            out << (c ? ", " : "") << "{\"cell\": " << (c + 1) << ", \"values\": {";
+            for (size_t a = 0; a < cell.axis_values.size(); a++) {
+                out << (a ? ", " : "") << json_string(cell.axis_values[a].first) << ": "
+                    << json_string(cell.axis_values[a].second);
+            }
+            out << "}, \"status\": " << json_string(cell.status) << ", \"seconds\": " << cell.seconds
+                << ", \"log\": " << json_string(cell.log) << ", \"args\": [";
+            for (size_t i = 0; i < cell.args.size(); i++) out << (i ? ", " : "") << json_string(cell.args[i]);
+            out << "]";
+            if (!cell.rows.empty()) {
+                // Parameters and environment are the same for every run of a cell
+                out << ", \"parameters_and_environment\": ";
+                object(cell, cell.rows[0], false);
+            }
+            out << ", \"runs\": [";
+            for (size_t r = 0; r < cell.rows.size(); r++) {
+                out << (r ? ", " : "");
+                object(cell, cell.rows[r], true);
+            }
+            out << "]}";
+        }
+        out << "]}" << std::endl;
+    }
+
+    void write_csv(std::ostream& out, const std::vector<Cell>& cells) const {
+        // Result columns in first-seen order; cells whose reports lack one leave it empty
+        std::vector<std::string> columns;
+        for (const Cell& cell : cells) {
+            for (const std::string& name : cell.header) {
+                if (result_column(name) && std::find(columns.begin(), columns.end(), name) == columns.end()) {
+                    columns.push_back(name);
+                }
+            }
+        }
+        out << "cell";
+        for (const Axis& axis : axes) out << "," << csv_field(axis.name);
+        out << ",status,cell_seconds";
+        for (const std::string& name : columns) out << "," << csv_field(name);
+        out << "\n";
+        for (size_t c = 0; c < cells.size(); c++) {
+            const Cell& cell = cells[c];
+            std::vector<std::vector<std::string>> rows = cell.rows;
+            if (rows.empty()) rows.emplace_back();
+            for (const auto& row : rows) {
+                out << (c + 1);
+                for (const auto& pair : cell.axis_values) out << "," << csv_field(pair.second);
+                out << "," << csv_field(cell.status) << "," << cell.seconds;
+                for (const std::string& name : columns) out << "," << csv_field(column(cell, row, name));
+                out << "\n";
+            }
+        }
+        out.flush();
+    }
+
+    std::string config_path;
+    std::map<std::string, std::string> fixed;
+    std::vector<Axis> axes;
+    std::vector<std::vector<std::pair<std::string, std::string>>> excludes;
+    double timeout_seconds = 0;
+    std::string log_dir = "suite_logs";
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+// Fixed set of threads running queued tasks, the native stand-in for the
+// asyncio default executor used by file_manager.py. The queue is unbounded
+// (fire-and-forget like run_in_executor); each task is told the index of the
+// worker running it so callers can keep per-thread state without locks.
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TaskPool {
+public:
+    using Task = std::function<void(int worker)>;
+
+    TaskPool() = default;
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+    ~TaskPool() { stop(); }
+
+    void start(int num_threads) {
+        for (int t = 0; t < num_threads; t++) {
+            workers.emplace_back([this, t]() { worker_loop(t); });
+        }
+    }
+
+    // Runs every queued task, then joins the workers
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        not_empty.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+    }
+
+    int size() const { return (int)workers.size(); }
+
+    void submit(Task task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+        }
+        not_empty.notify_one();
+    }
+
+private:
+    void worker_loop(int worker) {
+        while (true) {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                not_empty.wait(lock, [this] { return !tasks.empty() || stopping; });
+                if (tasks.empty()) {
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task(worker);
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::deque<Task> tasks;
+    bool stopping = false;
+};
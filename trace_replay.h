@@ -0,0 +1,291 @@
+#pragma once
+
+// Recorded request traces for --workload=replay. A trace is a sequence of
+// read, write and delete operations on files of the set, each with the time
+// it was issued and its size. A background thread parses the trace into a
+// bounded queue of record blocks while it is replayed, so a trace of any
+// length replays in constant memory and parsing stays off the issuing threads.
+// Two formats, told apart by the first bytes of the file:
+//   JSONL   one object per line, e.g.
+//             {"t": 0.0125, "op": "read", "file": 17, "size": 65536}
+//           "t" is seconds (or "t_us" microseconds), "op" is read, write or
+//           delete, "file" is 1..N (or a string "key", hashed onto 1..N) and
+//           "size" is bytes (0 or missing: the whole file). Blank lines and
+//           lines starting with '#' are skipped.
+//   binary  "FGTRACE1", then 24-byte little-endian records {u64 time_ns,
+//           u32 file, u32 size, u8 op, 7 bytes padding}, as written from a
+//           JSONL trace by TraceReader::convert (--trace_convert).
+// Times are delivered relative to the first record.
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum TraceOp : uint8_t { TRACE_READ = 0, TRACE_WRITE = 1, TRACE_DELETE = 2 };
+
+struct TraceRecord {
+    uint64_t time_ns;
+    uint32_t file_num;
+    uint32_t size;      // Bytes (0 = the whole file)
+    uint8_t op;         // TraceOp
+    uint8_t padding[7];
+};
+static_assert(sizeof(TraceRecord) == 24, "binary trace records are 24 bytes");
+
+static const char TRACE_MAGIC[8] = {'F', 'G', 'T', 'R', 'A', 'C', 'E', '1'};
+
+class TraceReader {
+public:
+    TraceReader() = default;
+    TraceReader(const TraceReader&) = delete;
+    TraceReader& operator=(const TraceReader&) = delete;
+    ~TraceReader() { stop(); }
+
+    // Opens the trace at `path` for files 1..num_files. Returns false if it
+    // cannot be read.
+    bool open(const std::string& path, int num_files) {
+        trace_path = path;
+        files = num_files;
+        in.open(path, std::ios::binary);
+        if (!in) {
+            std::cerr << "Error opening trace " << path << " (errno: " << errno << ")" << std::endl;
+            return false;
+        }
+        char magic[sizeof(TRACE_MAGIC)] = {};
+        in.read(magic, sizeof(magic));
+        binary = in.gcount() == (std::streamsize)sizeof(magic) && memcmp(magic, TRACE_MAGIC, sizeof(magic)) == 0;
+        if (!binary) {
+            in.clear();
+            in.seekg(0);
+        }
+        return true;
+    }
+
+    // Starts the parse thread, which keeps up to `queue_blocks` blocks of
+    // records ready ahead of the replay
+    void start(size_t queue_blocks = 64) {
+        capacity = std::max<size_t>(1, queue_blocks);
+        parser = std::thread([this] { parse_loop(); });
+    }
+
+    // Next record in trace order. Blocks while the parser is behind; returns
+    // false at the end of the trace, on a parse error or once stopped.
+    bool next(TraceRecord& record) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (position == current.size()) {
+            not_empty.wait(lock, [this] { return !blocks.empty() || parsed_all || stopping; });
+            if (blocks.empty()) return false;
+            current.swap(blocks.front());
+            blocks.pop_front();
+            position = 0;
+            not_full.notify_one();
+        }
+        record = current[position++];
+        delivered++;
+        return true;
+    }
+
+    // Ends parsing early (e.g. at a --duration deadline) and joins the parser
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        not_full.notify_all();
+        not_empty.notify_all();
+        if (parser.joinable()) parser.join();
+    }
+
+    bool failed() const { return error_occurred; }
+    const char* format() const { return binary ? "binary" : "jsonl"; }
+    uint64_t records() const { return delivered; }
+
+    // Writes the JSONL (or binary) trace at `from` as a binary trace at `to`.
+    // Returns false on error.
+    static bool convert(const std::string& from, const std::string& to, int num_files) {
+        TraceReader reader;
+        if (!reader.open(from, num_files)) return false;
+        std::ofstream out(to, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "Error creating trace " << to << " (errno: " << errno << ")" << std::endl;
+            return false;
+        }
+        out.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+        TraceRecord record;
+        uint64_t count = 0;
+        while (reader.read_record(record)) {
+            out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+            count++;
+        }
+        if (reader.error_occurred || !out.flush()) {
+            if (!reader.error_occurred) std::cerr << "Error writing trace " << to << std::endl;
+            return false;
+        }
+        std::cout << "Converted " << count << " trace records from " << from << " to " << to << std::endl;
+        return true;
+    }
+
+private:
+    static const size_t BLOCK_RECORDS = 4096;
+
+    void parse_loop() {
+        std::vector<TraceRecord> block;
+        block.reserve(BLOCK_RECORDS);
+        TraceRecord record;
+        bool more = true;
+        while (more) {
+            more = read_record(record);
+            if (more) block.push_back(record);
+            if (block.size() < BLOCK_RECORDS && more) continue;
+            std::unique_lock<std::mutex> lock(mutex);
+            not_full.wait(lock, [this] { return blocks.size() < capacity || stopping; });
+            if (stopping) break;
+            if (!block.empty()) blocks.push_back(std::move(block));
+            block = std::vector<TraceRecord>();
+            block.reserve(BLOCK_RECORDS);
+            lock.unlock();
+            not_empty.notify_all();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        parsed_all = true;
+        not_empty.notify_all();
+    }
+
+    // Reads the next record, with its time made relative to the first one
+    bool read_record(TraceRecord& record) {
+        bool ok = binary ? read_binary(record) : read_jsonl(record);
+        if (!ok) return false;
+        if (record.file_num < 1 || (int)record.file_num > files || record.op > TRACE_DELETE) {
+            std::cerr << "Error in trace " << trace_path << " record " << line_number << ": file "
+                      << record.file_num << " outside 1.." << files << " or unknown op" << std::endl;
+            error_occurred = true;
+            return false;
+        }
+        if (!have_origin) {
+            origin_ns = record.time_ns;
+            have_origin = true;
+        }
+        record.time_ns = record.time_ns >= origin_ns ? record.time_ns - origin_ns : 0;
+        return true;
+    }
+
+    bool read_binary(TraceRecord& record) {
+        in.read(reinterpret_cast<char*>(&record), sizeof(record));
+        line_number++;
+        if (in.gcount() == (std::streamsize)sizeof(record)) return true;
+        if (in.gcount() != 0) {
+            std::cerr << "Error in trace " << trace_path << ": truncated record " << line_number << std::endl;
+            error_occurred = true;
+        }
+        return false;
+    }
+
+    bool read_jsonl(TraceRecord& record) {
+        std::string line;
+        while (std::getline(in, line)) {
+            line_number++;
+            size_t first = line.find_first_not_of(" \t\r");
+            if (first == std::string::npos || line[first] == '#') continue;
+            if (parse_line(line, record)) return true;
+            std::cerr << "Error in trace " << trace_path << " line " << line_number << ": " << line << std::endl;
+            error_occurred = true;
+            return false;
+        }
+        return false;
+    }
+
+    bool parse_line(const std::string& line, TraceRecord& record) const {
+        memset(&record, 0, sizeof(record));
+        std::string value;
+        try {
+            if (json_field(line, "t", value)) {
+                double seconds = std::stod(value);
+                if (seconds < 0) return false;
+                record.time_ns = (uint64_t)(seconds * 1e9);
+            } else if (json_field(line, "t_us", value)) {
+                record.time_ns = std::stoull(value) * 1000;
+            } else {
+                return false;
+            }
+            if (!json_field(line, "op", value)) return false;
+            if (value == "read") record.op = TRACE_READ;
+            else if (value == "write") record.op = TRACE_WRITE;
+            else if (value == "delete") record.op = TRACE_DELETE;
+            else return false;
+            if (json_field(line, "file", value)) {
+                record.file_num = (uint32_t)std::stoul(value);
+            } else if (json_field(line, "key", value)) {
+                record.file_num = (uint32_t)(fnv1a(value) % (uint64_t)files) + 1;
+            } else {
+                return false;
+            }
+            if (json_field(line, "size", value)) record.size = (uint32_t)std::stoul(value);
+        } catch (const std::exception&) {
+            return false;
+        }
+        return true;
+    }
+
+    // Value of top-level field `key` of a flat JSON object: the contents of a
+    // string, or the raw text of a number. No nesting or escapes are needed
+    // for trace records.
+    static bool json_field(const std::string& line, const char* key, std::string& value) {
+        std::string quoted = std::string("\"") + key + "\"";
+        size_t pos = 0;
+        while ((pos = line.find(quoted, pos)) != std::string::npos) {
+            size_t colon = line.find_first_not_of(" \t", pos + quoted.size());
+            pos += quoted.size();
+            if (colon == std::string::npos || line[colon] != ':') continue;
+            size_t start = line.find_first_not_of(" \t", colon + 1);
+            if (start == std::string::npos) return false;
+            if (line[start] == '"') {
+                size_t end = line.find('"', start + 1);
+                if (end == std::string::npos) return false;
+                value = line.substr(start + 1, end - start - 1);
+            } else {
+                size_t end = line.find_first_of(",} \t\r", start);
+                value = line.substr(start, end == std::string::npos ? std::string::npos : end - start);
+            }
+            return true;
+        }
+        return false;
+    }
+
+    static uint64_t fnv1a(const std::string& key) {
+        uint64_t h = 0xcbf29ce484222325ull;
+        for (unsigned char c : key) h = (h ^ c) * 0x100000001b3ull;
+        return h;
+    }
+
+    std::string trace_path;
+    std::ifstream in;
+    int files = 0;
+    bool binary = false;
+    uint64_t line_number = 0;
+    uint64_t origin_ns = 0;
+    bool have_origin = false;
+    std::thread parser;
+
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<std::vector<TraceRecord>> blocks;  // Parsed, not yet replayed
+    size_t capacity = 64;
+    bool parsed_all = false;
+    bool stopping = false;
+    std::atomic<bool> error_occurred{false};
+    // Consumer side, guarded by `mutex`
+    std::vector<TraceRecord> current;
+    size_t position = 0;
+    uint64_t delivered = 0;
+};
@@ -0,0 +1,250 @@
+#pragma once
+
+// Minimal io_uring wrapper on top of the raw syscalls, so the benchmark does
+// not depend on liburing being installed. Only what the read/write engines
+// need is implemented: ring setup, registered buffers/files, SQE submission
+// and CQE reaping. Rings set up with IORING_SETUP_SQPOLL are submitted to
+// without a syscall unless the kernel's SQ thread has gone idle; with
+// IORING_SETUP_IOPOLL every wait polls the device for completions.
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+class IoUring {
+public:
+    IoUring() = default;
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+    ~IoUring() { destroy(); }
+
+    // Returns 0 on success or -errno.
+    int init(unsigned entries, unsigned flags) {
+        struct io_uring_params p;
+        memset(&p, 0, sizeof(p));
+        p.flags = flags;
+        return init(entries, p);
+    }
+
+    int init(unsigned entries, struct io_uring_params& p) {
+        ring_fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+        if (ring_fd < 0) {
+            ring_fd = -1;
+            return -errno;
+        }
+        setup_flags = p.flags;
+
+        sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+        bool single_mmap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            sq_ring_size = cq_ring_size = (sq_ring_size > cq_ring_size) ? sq_ring_size : cq_ring_size;
+        }
+
+        sq_ring_ptr = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+        if (sq_ring_ptr == MAP_FAILED) {
+            sq_ring_ptr = nullptr;
+            int err = -errno;
+            destroy();
+            return err;
+        }
+        if (single_mmap) {
+            cq_ring_ptr = sq_ring_ptr;
+        } else {
+            cq_ring_ptr = mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+            if (cq_ring_ptr == MAP_FAILED) {
+                cq_ring_ptr = nullptr;
+                int err = -errno;
+                destroy();
+                return err;
+            }
+        }
+        sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+        sqes = static_cast<struct io_uring_sqe*>(mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+                                                      MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) {
+            sqes = nullptr;
+            int err = -errno;
+            destroy();
+            return err;
+        }
+
+        char* sq = static_cast<char*>(sq_ring_ptr);
+        sq_head = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+        sq_tail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+        sq_flags = reinterpret_cast<unsigned*>(sq + p.sq_off.flags);
+        sq_mask = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+        sq_entries = p.sq_entries;
+        unsigned* sq_array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+        // Identity mapping: SQE slot i is always submitted from array slot i
+        for (unsigned i = 0; i < sq_entries; i++) {
+            sq_array[i] = i;
+        }
+
+        char* cq = static_cast<char*>(cq_ring_ptr);
+        cq_head = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+        cq_mask = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+        cqes = reinterpret_cast<struct io_uring_cqe*>(cq + p.cq_off.cqes);
+
+        sqe_tail = *sq_tail;
+        return 0;
+    }
+
+    void destroy() {
+        if (sqes) munmap(sqes, sqes_size);
+        if (cq_ring_ptr && cq_ring_ptr != sq_ring_ptr) munmap(cq_ring_ptr, cq_ring_size);
+        if (sq_ring_ptr) munmap(sq_ring_ptr, sq_ring_size);
+        if (ring_fd >= 0) close(ring_fd);
+        sqes = nullptr;
+        sq_ring_ptr = cq_ring_ptr = nullptr;
+        ring_fd = -1;
+    }
+
+    unsigned entries() const { return sq_entries; }
+    unsigned flags() const { return setup_flags; }
+    // Times submit() had to wake an idle SQPOLL thread
+    unsigned long long sq_wakeups() const { return wakeups; }
+
+    int register_buffers(const std::vector<struct iovec>& iovs) {
+        return do_register(IORING_REGISTER_BUFFERS, iovs.data(), (unsigned)iovs.size());
+    }
+
+    // Registers a (possibly sparse, -1 filled) fixed file table
+    int register_files(const std::vector<int>& fds) {
+        return do_register(IORING_REGISTER_FILES, fds.data(), (unsigned)fds.size());
+    }
+
+    // Replaces the fd stored in fixed file slot `slot`
+    int update_file(unsigned slot, int fd) {
+        struct io_uring_files_update update;
+        memset(&update, 0, sizeof(update));
+        update.offset = slot;
+        update.fds = (unsigned long)&fd;
+        int ret = do_register(IORING_REGISTER_FILES_UPDATE, &update, 1);
+        return ret < 0 ? ret : 0;
+    }
+
+    // Returns a zeroed SQE, or nullptr if the submission queue is full
+    struct io_uring_sqe* get_sqe() {
+        unsigned head = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+        if (sqe_tail - head >= sq_entries) {
+            return nullptr;
+        }
+        struct io_uring_sqe* sqe = &sqes[sqe_tail & sq_mask];
+        sqe_tail++;
+        memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+    // Publishes all queued SQEs and optionally waits for `wait_nr` completions.
+    // Returns the number of SQEs consumed by the kernel or -errno.
+    int submit(unsigned wait_nr = 0) {
+        unsigned to_submit = sqe_tail - *sq_tail;
+        __atomic_store_n(sq_tail, sqe_tail, __ATOMIC_RELEASE);
+        unsigned enter_flags = (wait_nr > 0) ? IORING_ENTER_GETEVENTS : 0;
+        if (setup_flags & IORING_SETUP_SQPOLL) {
+            // The SQ thread picks the tail up by itself; enter only to wake it or to wait.
+            // The fence orders the tail store before the NEED_WAKEUP check.
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            if (__atomic_load_n(sq_flags, __ATOMIC_RELAXED) & IORING_SQ_NEED_WAKEUP) {
+                enter_flags |= IORING_ENTER_SQ_WAKEUP;
+                wakeups++;
+            }
+            if (enter_flags == 0) return (int)to_submit;
+        }
+        return enter(to_submit, wait_nr, enter_flags);
+    }
+
+    // Takes back SQEs published by submit() that the kernel did not consume
+    // (a failed or short io_uring_enter), so they can never run later.
+    // Returns how many were dropped. Not for SQPOLL rings, whose thread
+    // consumes the ring on its own.
+    unsigned discard_unsubmitted() {
+        unsigned head = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+        unsigned dropped = sqe_tail - head;
+        __atomic_store_n(sq_tail, head, __ATOMIC_RELEASE);
+        sqe_tail = head;
+        return dropped;
+    }
+
+    // Returns the next completion without blocking, or nullptr if none is ready
+    struct io_uring_cqe* peek_cqe() {
+        unsigned head = *cq_head;
+        unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        if (head == tail) {
+            return nullptr;
+        }
+        return &cqes[head & cq_mask];
+    }
+
+    // Blocks until a completion is available. Returns 0 or -errno.
+    int wait_cqe(struct io_uring_cqe** cqe_out) {
+        while (true) {
+            struct io_uring_cqe* cqe = peek_cqe();
+            if (cqe) {
+                *cqe_out = cqe;
+                return 0;
+            }
+            int ret = enter(0, 1, IORING_ENTER_GETEVENTS);
+            if (ret < 0 && ret != -EINTR && ret != -EAGAIN) {
+                return ret;
+            }
+        }
+    }
+
+    void cqe_seen() {
+        __atomic_store_n(cq_head, *cq_head + 1, __ATOMIC_RELEASE);
+    }
+
+    static void prep_rw(struct io_uring_sqe* sqe, int op, int fd, const void* addr,
+                        unsigned len, unsigned long long offset) {
+        sqe->opcode = (unsigned char)op;
+        sqe->fd = fd;
+        sqe->addr = (unsigned long long)addr;
+        sqe->len = len;
+        sqe->off = offset;
+    }
+
+private:
+    int enter(unsigned to_submit, unsigned min_complete, unsigned enter_flags) {
+        int ret = (int)syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete,
+                               enter_flags, nullptr, 0);
+        return ret < 0 ? -errno : ret;
+    }
+
+    int do_register(unsigned opcode, const void* arg, unsigned nr_args) {
+        int ret = (int)syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args);
+        return ret < 0 ? -errno : ret;
+    }
+
+    int ring_fd = -1;
+    unsigned setup_flags = 0;
+
+    void* sq_ring_ptr = nullptr;
+    void* cq_ring_ptr = nullptr;
+    size_t sq_ring_size = 0;
+    size_t cq_ring_size = 0;
+    struct io_uring_sqe* sqes = nullptr;
+    size_t sqes_size = 0;
+
+    unsigned* sq_head = nullptr;
+    unsigned* sq_tail = nullptr;
+    unsigned* sq_flags = nullptr;
+    unsigned sq_mask = 0;
+    unsigned sq_entries = 0;
+    unsigned sqe_tail = 0;
+    unsigned long long wakeups = 0;
+
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned cq_mask = 0;
+    struct io_uring_cqe* cqes = nullptr;
+};
@@ -0,0 +1,211 @@
+#pragma once
+
+// Data integrity stamps for --verify. Every 4 KB block a writer produces
+// starts with a header naming the entry (file or slab slot), the block index
+// and the write's generation, followed by a CRC32C of the rest of the block;
+// readers recompute the CRC and check the header in the buffer the data landed
+// in. A CRC mismatch is corruption, a wrong entry or block index a misdirected
+// or stale block, a generation older than the last write that had completed
+// before the read began a stale read, and blocks of one read carrying
+// different generations a torn read (expected only while a write to the same
+// entry was in flight). CRC32C uses the SSE4.2 crc32 instruction when the CPU
+// has it (checked at run time), ARMv8 CRC when built for it, and a table
+// otherwise.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define VERIFY_HAVE_SSE42_TARGET 1
+#endif
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+static const size_t VERIFY_BLOCK = 4096;
+
+// Header at the start of every block; the CRC covers everything after `crc`
+struct BlockStamp {
+    uint32_t magic;
+    uint32_t crc;
+    uint64_t generation;
+    uint32_t file_num;
+    uint32_t block;
+};
+static const uint32_t VERIFY_MAGIC = 0x31564746;  // "FGV1"
+
+static inline uint32_t crc32c_table(uint32_t crc, const unsigned char* p, size_t len) {
+    static const auto table = [] {
+        std::unique_ptr<uint32_t[]> t(new uint32_t[256]);
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c >> 1) ^ (0x82F63B78u & (0u - (c & 1)));
+            t[i] = c;
+        }
+        return t;
+    }();
+    for (size_t i = 0; i < len; i++) crc = table[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+    return crc;
+}
+
+#ifdef VERIFY_HAVE_SSE42_TARGET
+__attribute__((target("sse4.2")))
+static inline uint32_t crc32c_sse42(uint32_t crc, const unsigned char* p, size_t len) {
+#if defined(__x86_64__)
+    uint64_t c = crc;
+    for (; len >= 8; p += 8, len -= 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        c = _mm_crc32_u64(c, word);
+    }
+    crc = (uint32_t)c;
+#endif
+    for (; len > 0; p++, len--) crc = _mm_crc32_u8(crc, *p);
+    return crc;
+}
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+static inline uint32_t crc32c_armv8(uint32_t crc, const unsigned char* p, size_t len) {
+    for (; len >= 8; p += 8, len -= 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        crc = __crc32cd(crc, word);
+    }
+    for (; len > 0; p++, len--) crc = __crc32cb(crc, *p);
+    return crc;
+}
+#endif
+
+using Crc32cFn = uint32_t (*)(uint32_t, const unsigned char*, size_t);
+
+// Fastest CRC32C kernel this CPU runs, and its name
+static inline Crc32cFn crc32c_kernel(const char** name = nullptr) {
+#ifdef VERIFY_HAVE_SSE42_TARGET
+    if (__builtin_cpu_supports("sse4.2")) {
+        if (name) *name = "sse4.2 crc32";
+        return crc32c_sse42;
+    }
+#endif
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+    if (name) *name = "armv8 crc32c";
+    return crc32c_armv8;
+#endif
+    if (name) *name = "table";
+    return crc32c_table;
+}
+
+static inline uint32_t crc32c(const void* data, size_t len) {
+    static const Crc32cFn kernel = crc32c_kernel();
+    return ~kernel(~0u, static_cast<const unsigned char*>(data), len);
+}
+
+class Verifier {
+public:
+    // What one read of an entry saw so far (check() across its chunks, then finish())
+    struct ReadCheck {
+        uint64_t floor = 0;       // Generation committed before the read began
+        uint64_t generation = 0;  // Oldest block seen
+        bool seen = false;
+        bool torn = false;
+    };
+
+    // Entries 1..num_files, all written as generation 0 by the populate step
+    void init(int num_files) {
+        committed.reset(new std::atomic<uint64_t>[num_files + 1]);
+        for (int i = 0; i <= num_files; i++) committed[i].store(0, std::memory_order_relaxed);
+        crc32c_kernel(&kernel_name);
+    }
+
+    // Stamps `len` bytes of `buffer` holding bytes [offset, offset + len) of
+    // entry `file_num`; `offset` is block aligned and so is `len` unless it
+    // ends the entry
+    static void stamp(char* buffer, size_t len, long long offset, int file_num, uint64_t generation) {
+        for (size_t pos = 0; pos < len; pos += VERIFY_BLOCK) {
+            size_t block_len = std::min(VERIFY_BLOCK, len - pos);
+            BlockStamp header = {VERIFY_MAGIC, 0, generation, (uint32_t)file_num,
+                                 (uint32_t)((offset + (long long)pos) / (long long)VERIFY_BLOCK)};
+            memcpy(buffer + pos, &header, sizeof(header));
+            header.crc = crc32c(buffer + pos + 8, block_len - 8);
+            memcpy(buffer + pos + 4, &header.crc, sizeof(header.crc));
+        }
+    }
+
+    // Generation for the next write of an entry, and its completion
+    uint64_t begin_write() { return next_generation.fetch_add(1, std::memory_order_relaxed); }
+    void end_write(int file_num, uint64_t generation) {
+        uint64_t seen = committed[file_num].load(std::memory_order_relaxed);
+        while (seen < generation &&
+               !committed[file_num].compare_exchange_weak(seen, generation, std::memory_order_release)) {
+        }
+    }
+
+    ReadCheck begin_read(int file_num) const {
+        ReadCheck check;
+        check.floor = committed[file_num].load(std::memory_order_acquire);
+        return check;
+    }
+
+    // Checks the blocks of `len` bytes read at `offset` of entry `file_num`
+    void check(const char* buffer, size_t len, long long offset, int file_num, ReadCheck& read) {
+        uint64_t bad_crc = 0, misplaced = 0;
+        for (size_t pos = 0; pos + sizeof(BlockStamp) <= len; pos += VERIFY_BLOCK) {
+            size_t block_len = std::min(VERIFY_BLOCK, len - pos);
+            BlockStamp header;
+            memcpy(&header, buffer + pos, sizeof(header));
+            if (header.magic != VERIFY_MAGIC || header.crc != crc32c(buffer + pos + 8, block_len - 8)) {
+                bad_crc++;
+                continue;
+            }
+            if (header.file_num != (uint32_t)file_num ||
+                header.block != (uint32_t)((offset + (long long)pos) / (long long)VERIFY_BLOCK)) {
+                misplaced++;
+                continue;
+            }
+            if (!read.seen) {
+                read.generation = header.generation;
+                read.seen = true;
+            } else if (header.generation != read.generation) {
+                read.torn = true;
+                if (header.generation < read.generation) read.generation = header.generation;
+            }
+        }
+        blocks.fetch_add((len + VERIFY_BLOCK - 1) / VERIFY_BLOCK, std::memory_order_relaxed);
+        if (bad_crc) crc_errors.fetch_add(bad_crc, std::memory_order_relaxed);
+        if (misplaced) misplaced_blocks.fetch_add(misplaced, std::memory_order_relaxed);
+    }
+
+    // Ends one read: torn if its blocks disagree, stale if older than the floor
+    void finish(const ReadCheck& read) {
+        reads.fetch_add(1, std::memory_order_relaxed);
+        if (read.torn) torn_reads.fetch_add(1, std::memory_order_relaxed);
+        if (read.seen && read.generation < read.floor) stale_reads.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Corruption, misdirected or stale data (torn reads alone are not failures)
+    bool failed() const { return crc_errors > 0 || misplaced_blocks > 0 || stale_reads > 0; }
+
+    void print() const {
+        std::cout << "Verification (" << kernel_name << "): " << reads << " reads, " << blocks << " blocks; "
+                  << crc_errors << " CRC errors, " << misplaced_blocks << " misplaced blocks, " << stale_reads
+                  << " stale reads, " << torn_reads << " torn reads" << std::endl;
+        if (failed()) std::cerr << "Error: data verification failed" << std::endl;
+    }
+
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> committed;
+    std::atomic<uint64_t> next_generation{1};
+    const char* kernel_name = "table";
+    std::atomic<uint64_t> reads{0};
+    std::atomic<uint64_t> blocks{0};
+    std::atomic<uint64_t> crc_errors{0};
+    std::atomic<uint64_t> misplaced_blocks{0};
+    std::atomic<uint64_t> stale_reads{0};
+    std::atomic<uint64_t> torn_reads{0};
+};
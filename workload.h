@@ -0,0 +1,75 @@
+#pragma once
+
+// File selection for the measured loops. Instead of the uniform shuffle the
+// loops can draw files from a skewed distribution:
+//   uniform  every file equally likely
+//   zipf     Zipfian over popularity ranks (YCSB generator, theta in (0,1))
+//   hotset   hot_access of the accesses go to the hottest hot_fraction of the files
+// Ranks are mapped to file numbers through a shuffled permutation, so the hot
+// files are spread over the directory rather than being f1, f2, ...
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+class FileSelector {
+public:
+    // `rank_to_file` holds the file numbers in popularity order (most popular first)
+    FileSelector(const std::string& distribution, std::vector<int> rank_to_file,
+                 double zipf_theta, double hot_fraction, double hot_access)
+        : distribution(distribution), files(std::move(rank_to_file)),
+          theta(zipf_theta), hot_access(hot_access) {
+        n = (long long)files.size();
+        hot_count = (long long)(hot_fraction * n);
+        if (hot_count < 1) hot_count = 1;
+        if (hot_count > n) hot_count = n;
+        if (distribution == "zipf") {
+            for (long long i = 1; i <= n; i++) {
+                zetan += 1.0 / std::pow((double)i, theta);
+            }
+            double zeta2 = 1.0 + 1.0 / std::pow(2.0, theta);
+            alpha = 1.0 / (1.0 - theta);
+            eta = (1.0 - std::pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / zetan);
+        }
+    }
+
+    static bool valid_distribution(const std::string& name) {
+        return name == "uniform" || name == "zipf" || name == "hotset";
+    }
+
+    // Returns a file number; `rng` is the calling thread's generator
+    int next(std::mt19937_64& rng) const {
+        return files[next_rank(rng)];
+    }
+
+private:
+    long long next_rank(std::mt19937_64& rng) const {
+        std::uniform_real_distribution<double> uniform01(0.0, 1.0);
+        if (distribution == "zipf") {
+            double u = uniform01(rng);
+            double uz = u * zetan;
+            if (uz < 1.0) return 0;
+            if (uz < 1.0 + std::pow(0.5, theta)) return n > 1 ? 1 : 0;
+            long long rank = (long long)(n * std::pow(eta * u - eta + 1.0, alpha));
+            return rank < n ? rank : n - 1;
+        }
+        if (distribution == "hotset") {
+            if (uniform01(rng) < hot_access || hot_count == n) {
+                return (long long)(rng() % (unsigned long long)hot_count);
+            }
+            return hot_count + (long long)(rng() % (unsigned long long)(n - hot_count));
+        }
+        return (long long)(rng() % (unsigned long long)n);
+    }
+
+    std::string distribution;
+    std::vector<int> files;
+    long long n = 0;
+    double theta;
+    double hot_access;
+    long long hot_count = 1;
+    double zetan = 0;
+    double alpha = 0;
+    double eta = 0;
+};
@@ -0,0 +1,251 @@
+#pragma once
+
+// Native writer stage for manager mode, in place of the write semaphore and
+// fire-and-forget executor writes of file_manager.py. Producers queue writes
+// into one bounded queue and block only while it is full; a fixed set of
+// writer threads each takes up to `batch` queued writes at once, prepares them
+// (pick a target, unlink/open as the manager does), submits all transfers
+// together (one io_uring_enter for the batch, or back-to-back pwrite) and then
+// completes them. Queue occupancy and the time producers spent blocked are
+// counted so backpressure is visible instead of hidden in request latency.
+
+#include <linux/io_uring.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "file_managers.h"
+#include "latency_histogram.h"
+#include "uring.h"
+
+class WritePipeline {
+public:
+    // `use_uring` submits each batch through a per-writer ring; falls back to
+    // pwrite with a warning if the ring cannot be set up
+    WritePipeline(BaseFileManager& manager, int num_writers, int capacity, int batch, bool use_uring)
+        : manager(manager), num_writers(num_writers), capacity(capacity), batch(batch), use_uring(use_uring) {}
+    ~WritePipeline() { stop(); }
+
+    WritePipeline(const WritePipeline&) = delete;
+    WritePipeline& operator=(const WritePipeline&) = delete;
+
+    void start() {
+        latency.resize(num_writers);
+        for (int w = 0; w < num_writers; w++) {
+            rings.push_back(std::make_unique<IoUring>());
+        }
+        if (use_uring) {
+            for (auto& ring : rings) {
+                int ret = ring->init((unsigned)batch, 0);
+                if (ret < 0) {
+                    std::cout << "Warning: io_uring setup failed (" << -ret << "), pipeline writes use pwrite"
+                              << std::endl;
+                    use_uring = false;
+                    break;
+                }
+            }
+        }
+        for (int w = 0; w < num_writers; w++) {
+            writers.emplace_back([this, w] { writer_loop(w); });
+        }
+    }
+
+    // Queues one write for request worker `worker_id`. Blocks only while the
+    // queue already holds `capacity` writes.
+    void submit(int worker_id, bool to_delete) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if ((int)queue.size() >= capacity) {
+            auto start_block = std::chrono::steady_clock::now();
+            not_full.wait(lock, [this] { return (int)queue.size() < capacity; });
+            blocked_ns += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start_block).count();
+            blocked_submits++;
+        }
+        queue.push_back({worker_id, to_delete, std::chrono::steady_clock::now()});
+        submits++;
+        occupancy_sum += queue.size();
+        max_occupancy = std::max(max_occupancy, queue.size());
+        lock.unlock();
+        not_empty.notify_one();
+    }
+
+    // Writes everything still queued, then joins the writer threads
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        not_empty.notify_all();
+        for (auto& writer : writers) writer.join();
+        writers.clear();
+    }
+
+    bool failed() const { return error_occurred; }
+
+    // Queue-to-completion latency of every write
+    LatencyHistogram write_latency() const {
+        LatencyHistogram merged;
+        for (const auto& h : latency) merged.merge(h);
+        return merged;
+    }
+
+    void print_stats() const {
+        std::cout << "Write pipeline: " << submits << " writes on " << num_writers << " writers ("
+                  << (use_uring ? "io_uring" : "pwrite") << "), " << batches << " batches of avg "
+                  << (batches > 0 ? (double)batched / batches : 0) << " (max " << batch << ")" << std::endl;
+        std::cout << "  Queue occupancy: avg " << (submits > 0 ? (double)occupancy_sum / submits : 0) << ", max "
+                  << max_occupancy << " of " << capacity << "; producers blocked " << blocked_submits
+                  << " times for " << blocked_ns / 1e6 << " ms" << std::endl;
+    }
+
+private:
+    struct QueuedWrite {
+        int worker_id;
+        bool to_delete;
+        std::chrono::steady_clock::time_point queued;
+    };
+
+    void writer_loop(int w) {
+        std::vector<QueuedWrite> taken;
+        std::vector<PendingWrite> pending;
+        std::vector<char> prepared;
+        std::vector<char> done;
+        uint64_t batch_number = 0;
+        while (true) {
+            taken.clear();
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                not_empty.wait(lock, [this] { return !queue.empty() || stopping; });
+                if (queue.empty()) return;
+                while (!queue.empty() && (int)taken.size() < batch) {
+                    taken.push_back(queue.front());
+                    queue.pop_front();
+                }
+                batches++;
+                batched += taken.size();
+            }
+            not_full.notify_all();
+
+            pending.assign(taken.size(), PendingWrite());
+            prepared.assign(taken.size(), 0);
+            done.assign(taken.size(), 0);
+            for (size_t i = 0; i < taken.size(); i++) {
+                prepared[i] = manager.prepare_write(taken[i].worker_id, taken[i].to_delete, pending[i]);
+                if (!prepared[i]) error_occurred = true;
+            }
+            if (use_uring) {
+                transfer_uring(*rings[w], ++batch_number, pending, prepared, done);
+            } else {
+                for (size_t i = 0; i < pending.size(); i++) {
+                    if (prepared[i]) done[i] = transfer_pwrite(pending[i]);
+                }
+            }
+            auto now = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < taken.size(); i++) {
+                if (!prepared[i]) continue;
+                if (!done[i]) error_occurred = true;
+                manager.complete_write(pending[i], done[i]);
+                latency[w].record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    now - taken[i].queued).count());
+            }
+        }
+    }
+
+    bool transfer_pwrite(const PendingWrite& write) const {
+        ssize_t written = pwrite(write.fd, manager.write_data(), manager.write_size(), write.offset);
+        if (written != (ssize_t)manager.write_size()) {
+            std::cerr << "Error writing " << write.name << " (errno: " << errno << ")" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Submits every prepared write of the batch with one io_uring_enter and
+    // reaps them all. CQE user_data carries the writer's batch number, so the
+    // completions of a batch abandoned after a wait error are dropped when
+    // they turn up during a later batch instead of being credited to it. SQEs
+    // the kernel did not take are withdrawn before their fds are closed.
+    // Writes not seen to complete stay !done and fail.
+    void transfer_uring(IoUring& ring, uint64_t batch_number, const std::vector<PendingWrite>& pending,
+                        const std::vector<char>& prepared, std::vector<char>& done) const {
+        while (ring.peek_cqe()) ring.cqe_seen();
+        std::vector<size_t> queued;
+        for (size_t i = 0; i < pending.size(); i++) {
+            if (!prepared[i]) continue;
+            struct io_uring_sqe* sqe = ring.get_sqe();
+            if (!sqe) {
+                std::cerr << "Error writing " << pending[i].name << ": io_uring submission queue full" << std::endl;
+                continue;
+            }
+            IoUring::prep_rw(sqe, IORING_OP_WRITE, pending[i].fd, manager.write_data(),
+                             (unsigned)manager.write_size(), (unsigned long long)pending[i].offset);
+            sqe->user_data = (batch_number << 32) | i;
+            queued.push_back(i);
+        }
+        if (queued.empty()) return;
+        int ret = ring.submit();
+        unsigned dropped = ring.discard_unsubmitted();
+        if (ret < 0 || dropped > 0) {
+            std::cerr << "Error submitting pipeline writes to io_uring (";
+            if (ret < 0) std::cerr << "errno: " << -ret << ", ";
+            std::cerr << dropped << " of " << queued.size() << " writes not submitted)" << std::endl;
+        }
+        // The kernel consumes SQEs in order, so the first ones are in flight
+        size_t in_flight = queued.size() - dropped;
+        size_t reaped = 0;
+        while (reaped < in_flight) {
+            struct io_uring_cqe* cqe;
+            int wait_ret = ring.wait_cqe(&cqe);
+            if (wait_ret < 0) {
+                std::cerr << "Error waiting for pipeline writes on io_uring (errno: " << -wait_ret << ", "
+                          << in_flight - reaped << " writes abandoned)" << std::endl;
+                return;
+            }
+            uint64_t user_data = cqe->user_data;
+            int res = cqe->res;
+            ring.cqe_seen();
+            if ((user_data >> 32) != (batch_number & 0xffffffffu)) continue;
+            size_t i = (size_t)(user_data & 0xffffffffu);
+            reaped++;
+            if (res == (int)manager.write_size()) {
+                done[i] = 1;
+            } else {
+                std::cerr << "Error writing " << pending[i].name << " (res: " << res << ")" << std::endl;
+            }
+        }
+    }
+
+    BaseFileManager& manager;
+    const int num_writers;
+    const int capacity;
+    const int batch;
+    bool use_uring;
+    std::vector<std::unique_ptr<IoUring>> rings;
+    std::vector<std::thread> writers;
+    std::vector<LatencyHistogram> latency;   // Per writer, merged after stop()
+    std::atomic<bool> error_occurred{false};
+
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    std::deque<QueuedWrite> queue;
+    bool stopping = false;
+    // Guarded by `mutex`
+    uint64_t submits = 0;
+    uint64_t occupancy_sum = 0;     // Queue length right after each submit
+    size_t max_occupancy = 0;
+    uint64_t blocked_submits = 0;
+    uint64_t blocked_ns = 0;
+    uint64_t batches = 0;
+    uint64_t batched = 0;
+};